@@ -0,0 +1,235 @@
+//
+// Benchmarks for writer latency, reader throughput and concurrent writes.
+// Results are printed to stdout, run with:
+//
+//   pio test -e native_bench -v
+//
+// Numbers depend on host CPU and load. Compare runs on the same machine only.
+//
+
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+auto elapsedNs(Clock::time_point start, Clock::time_point end) -> uint64_t {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+}
+
+void printLatency(const char* name, std::vector<uint64_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+
+    auto percentile = [&samples](size_t p) { return samples[(samples.size() - 1) * p / 100]; };
+
+    printf("%-28s p50: %5llu ns, p90: %5llu ns, p99: %5llu ns, max: %7llu ns\n", name,
+        static_cast<unsigned long long>(percentile(50)),
+        static_cast<unsigned long long>(percentile(90)),
+        static_cast<unsigned long long>(percentile(99)),
+        static_cast<unsigned long long>(samples.back()));
+}
+
+using LatencyBuffer = jetlog::RingBuffer<1024 * 64>;
+
+// Measures each push separately. Buffer is reset periodically, so that
+// eviction is not included (it's measured in contention test).
+template <typename TWriter, typename F>
+void benchPush(const char* name, F&& push) {
+    constexpr size_t Iterations = 100000;
+
+    static LatencyBuffer ringBuffer;
+    TWriter logWriter(ringBuffer);
+    std::vector<uint64_t> samples;
+    samples.reserve(Iterations);
+
+    for (size_t i = 0; i < Iterations; i++) {
+        if (i % 500 == 0) { ringBuffer.reset(); }
+
+        auto start = Clock::now();
+        push(logWriter, static_cast<uint32_t>(i));
+        samples.push_back(elapsedNs(start, Clock::now()));
+    }
+
+    printLatency(name, samples);
+}
+
+} // namespace
+
+TEST(Bench, WriterLatency) {
+    using DefaultWriter = jetlog::Writer<>;
+    using CompactWriter = jetlog::Writer<256, jetlog::CompactParamEncoders_32_And_Float>;
+    using InternWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, true>;
+    using TypedWriter = jetlog::BasicWriter<LatencyBuffer>;
+
+    benchPush<DefaultWriter>("no args", [](DefaultWriter& w, uint32_t) {
+        w.push("tag", jetlog::level::info, "Message without args");
+    });
+
+    benchPush<DefaultWriter>("3 ints", [](DefaultWriter& w, uint32_t i) {
+        w.push("tag", jetlog::level::info, "Values: {} {} {}", i, i + 1, i + 2);
+    });
+
+    benchPush<DefaultWriter>("string + float", [](DefaultWriter& w, uint32_t i) {
+        w.push("tag", jetlog::level::info, "Name: {}, value: {}", "sensor", static_cast<float>(i) * 0.5f);
+    });
+
+    benchPush<DefaultWriter>("long string", [](DefaultWriter& w, uint32_t) {
+        w.push("tag", jetlog::level::info, "Text: {}",
+            "Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod");
+    });
+
+    benchPush<DefaultWriter>("long static_str", [](DefaultWriter& w, uint32_t) {
+        w.push("tag", jetlog::level::info, "Text: {}",
+            jetlog::static_str("Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod"));
+    });
+
+    benchPush<CompactWriter>("3 ints, compact", [](CompactWriter& w, uint32_t i) {
+        w.push("tag", jetlog::level::info, "Values: {} {} {}", i, i + 1, i + 2);
+    });
+
+    benchPush<InternWriter>("3 ints, interned", [](InternWriter& w, uint32_t i) {
+        w.push("tag", jetlog::level::info, "Values: {} {} {}", i, i + 1, i + 2);
+    });
+
+    benchPush<TypedWriter>("3 ints, typed buffer", [](TypedWriter& w, uint32_t i) {
+        w.push("tag", jetlog::level::info, "Values: {} {} {}", i, i + 1, i + 2);
+    });
+
+    benchPush<DefaultWriter>("filtered out", [](DefaultWriter& w, uint32_t i) {
+        w.setLevel(jetlog::level::info);
+        w.push("tag", jetlog::level::verbose, "Values: {} {} {}", i, i + 1, i + 2);
+    });
+}
+
+TEST(Bench, ReaderThroughput) {
+    constexpr size_t BufferSize = 1024 * 64;
+    constexpr size_t Rounds = 200;
+
+    static jetlog::RingBuffer<BufferSize> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, jetlog::FormatCache<64>> cachedReader(ringBuffer);
+    etl::string<256> output;
+
+    auto fill = [&]() -> size_t {
+        ringBuffer.reset();
+        uint32_t count = 0;
+        // Stop before eviction starts
+        while (count < 1000) {
+            logWriter.push("tag", jetlog::level::info, "Values: {} {:x} {}", count, count, "text");
+            count++;
+        }
+        return count;
+    };
+
+    uint64_t pull_ns = 0, drain_ns = 0, cached_ns = 0;
+    size_t pulled = 0, drained = 0, cached = 0;
+
+    for (size_t round = 0; round < Rounds; round++) {
+        fill();
+        auto start = Clock::now();
+        while (logReader.pull(output)) { output.clear(); pulled++; }
+        pull_ns += elapsedNs(start, Clock::now());
+
+        fill();
+        start = Clock::now();
+        drained += logReader.drain(output, [](const etl::istring&) {});
+        drain_ns += elapsedNs(start, Clock::now());
+
+        fill();
+        start = Clock::now();
+        while (cachedReader.pull(output)) { output.clear(); cached++; }
+        cached_ns += elapsedNs(start, Clock::now());
+    }
+
+    ASSERT_GT(pulled, 0u);
+    ASSERT_GT(drained, 0u);
+    ASSERT_GT(cached, 0u);
+
+    printf("%-28s %8.0f records/s, %5.0f ns/record\n", "pull",
+        pulled * 1e9 / pull_ns, static_cast<double>(pull_ns) / pulled);
+    printf("%-28s %8.0f records/s, %5.0f ns/record\n", "drain",
+        drained * 1e9 / drain_ns, static_cast<double>(drain_ns) / drained);
+    printf("%-28s %8.0f records/s, %5.0f ns/record\n", "pull, format cache",
+        cached * 1e9 / cached_ns, static_cast<double>(cached_ns) / cached);
+}
+
+// N writers and one reader on shared buffer. Records are lost when reader
+// can't keep up (evicted), or when writers collide (see README, Known Edge
+// Cases).
+template <typename Buffer>
+void runContention(const char* name) {
+    constexpr size_t PushesPerThread = 100000;
+
+    printf("%s:\n", name);
+
+    for (size_t threads : {1, 2, 4, 8}) {
+        static Buffer ringBuffer;
+        ringBuffer.reset();
+        ringBuffer.resetStats();
+
+        std::atomic<bool> done{false};
+        std::atomic<size_t> failed{0};
+        size_t read = 0;
+
+        std::thread reader([&]() {
+            etl::vector<uint8_t, 256> record;
+            while (true) {
+                bool finished = done.load();
+                while (ringBuffer.readRecord(record)) { read++; }
+                if (finished) { break; }
+            }
+        });
+
+        auto start = Clock::now();
+
+        std::vector<std::thread> writers;
+        for (size_t t = 0; t < threads; t++) {
+            writers.emplace_back([&]() {
+                jetlog::Writer<> logWriter(ringBuffer);
+                for (uint32_t i = 0; i < PushesPerThread; i++) {
+                    if (!logWriter.push("tag", jetlog::level::info, "Values: {} {}", i, i)) { failed++; }
+                }
+            });
+        }
+        for (auto& w : writers) { w.join(); }
+
+        auto total_ns = elapsedNs(start, Clock::now());
+        done = true;
+        reader.join();
+
+        auto stats = ringBuffer.getStats();
+        size_t pushed = threads * PushesPerThread;
+        size_t written = pushed - failed.load();
+        ASSERT_LE(read, written);
+
+        // "evicted" - written, but overwritten before reader got them
+        printf("%zu writer(s): %6.0f ns/push, push failed: %5.2f%%, evicted: %5.2f%%, CAS retries: %zu\n",
+            threads,
+            static_cast<double>(total_ns) * threads / pushed,
+            100.0 * failed.load() / pushed,
+            100.0 * (written - read) / pushed,
+            stats.cas_retries);
+    }
+}
+
+TEST(Bench, Contention) {
+    constexpr size_t BufferSize = 1024 * 16;
+
+    runContention<jetlog::RingBuffer<BufferSize>>("RingBuffer");
+    runContention<jetlog::CacheAlignedRingBuffer<BufferSize>>("CacheAlignedRingBuffer");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -7,6 +7,47 @@ static jetlog::RingBuffer<1024*10> ringBuffer;
 Logger logger(ringBuffer);
 jetlog::Reader<> logReader(ringBuffer);
 
+//
+// Wakes up print-er task on new data, via FreeRTOS task notifications.
+// Writers can be interrupts, so ISR-safe variant is used there.
+//
+class TaskWaiter : public jetlog::IWaiter {
+public:
+    void notify() override {
+        TaskHandle_t handle = task.load(etl::memory_order_acquire);
+        // Not started yet. Data will be read on start anyway.
+        if (!handle) { return; }
+
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(handle, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(handle);
+        }
+    }
+
+    auto wait(uint32_t timeout_ms = WaitForever) -> bool override {
+        TickType_t ticks = timeout_ms == WaitForever ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+        return ulTaskNotifyTake(pdTRUE, ticks) > 0;
+    }
+
+    etl::atomic<TaskHandle_t> task{nullptr};
+};
+
+static TaskWaiter logWaiter;
+
+//
+// Streams formatted lines to Serial, so no line buffer is needed, and long
+// lines are not cut.
+//
+class SerialSink : public jetlog::ISink {
+public:
+    void write(const char* data, size_t size) override {
+        Serial.write(reinterpret_cast<const uint8_t*>(data), size);
+    }
+};
+
 //
 // This print-er is platform-specific. In this demo we use Serial to keep things
 // simple.
@@ -16,10 +57,14 @@ jetlog::Reader<> logReader(ringBuffer);
 //
 
 void logger_start() {
+    ringBuffer.setWaiter(&logWaiter);
+
     xTaskCreate([](void* pvParameters) {
         (void)pvParameters;
 
-        etl::string<1024> outputBuffer{};
+        SerialSink serialSink{};
+
+        logWaiter.task.store(xTaskGetCurrentTaskHandle(), etl::memory_order_release);
 
         Serial.begin(115200);
 
@@ -28,13 +73,11 @@ void logger_start() {
         while (!Serial) { vTaskDelay(pdMS_TO_TICKS(10)); }
 
         while (true) {
-            // Read and print log records, until there is no more data.
-            while (logReader.pull(outputBuffer)) {
-                Serial.println(outputBuffer.c_str());
-                outputBuffer.clear();
-            }
-            // If there is no data, wait a bit before trying again.
-            vTaskDelay(pdMS_TO_TICKS(10));
+            // Read and print all available log records, until buffer is empty.
+            while (logReader.drain(serialSink) > 0) {}
+
+            // Sleep until writers add new data.
+            logWaiter.wait();
         }
     }, "LogOutputTask", 1024 * 4, NULL, 0, NULL);
-}
\ No newline at end of file
+}
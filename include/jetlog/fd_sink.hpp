@@ -0,0 +1,42 @@
+#pragma once
+
+//
+// Sink to file descriptor (stdout, file, pipe, socket) for POSIX hosts. Not
+// included by default. Each write() is a syscall, wrap with BufferedSink to
+// reduce those.
+//
+
+#include "private/sink.hpp"
+
+#include <errno.h>
+#include <unistd.h>
+
+namespace jetlog {
+
+class FdSink : public ISink {
+public:
+    explicit FdSink(int descriptor) : fd{descriptor} {}
+
+    void write(const char* data, size_t size) override {
+        while (size > 0 && !failed) {
+            auto written = ::write(fd, data, size);
+
+            if (written < 0) {
+                if (errno != EINTR) { failed = true; }
+                continue;
+            }
+
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+    }
+
+    // True after write error. The rest of output is dropped.
+    auto hasFailed() const -> bool { return failed; }
+
+private:
+    int fd;
+    bool failed{false};
+};
+
+} // namespace jetlog
@@ -1,13 +1,24 @@
 #pragma once
 
+#include "private/clock.hpp"
+#include "private/format_cache.hpp"
+#include "private/persistent_ring_buffer.hpp"
+#include "private/raw_frame.hpp"
 #include "private/ring_buffer.hpp"
+#include "private/sequence.hpp"
+#include "private/sharded_ring_buffer.hpp"
+#include "private/sink.hpp"
 #include "private/string_tokenizer.hpp"
 #include "private/typelists.hpp"
 
+#include <etl/algorithm.h>
+#include <etl/atomic.h>
 #include <etl/limits.h>
 #include <etl/type_traits.h>
 #include <etl/utility.h>
 
+#include <string.h>
+
 namespace jetlog {
 
 namespace level {
@@ -33,108 +44,445 @@ constexpr T&& decayLiteralArg(T&& x) noexcept
     return etl::forward<T>(x);
 }
 
+// C strings are passed to encoders with length, to call strlen only once
+// (for record size and for write)
+inline auto sizedArg(const char* s) -> SizedCString { return { s, strlen(s) }; }
+inline auto sizedArg(char* s) -> SizedCString { return { s, strlen(s) }; }
+
+template <typename T>
+constexpr auto sizedArg(const T& x) noexcept -> const T& { return x; }
 
 
 
+
+//
+// Buffer - ring buffer type. Writer alias uses IRingBuffer, to accept any
+// buffer. Concrete type (for example `RingBuffer<1024>`) allows compiler to
+// inline allocation into push(), without virtual calls.
+//
+// InternStrings - store only pointers to tag and message, instead of copying
+// text. Both must be literals (or have static lifetime), and reader must be in
+// the same address space.
+//
+// MaxLevel - records with higher level are never written. Use with
+// `push<Level>()` to remove such calls at compile time.
+//
+// MaxTagFilters - size of table with per-tag levels (see setTagLevel()).
+//
+// Clock - timestamps source (see clock.hpp). Default one calls virtual
+// getTime(), custom one avoids virtual call and can be 64-bit.
+//
+// DeltaTime - store only low 16 bits of timestamp, and full value once per
+// 64K ticks. Saves 2-6 bytes per record, reader restores full time. Not for
+// ShardedRingBuffer.
+//
+// Sequence - number records, to let reader detect and report lost ones (see
+// SequenceTracker). Takes 2-7 bytes per record. Numbers are taken from ring
+// buffer, so several writers can share one buffer. Not for ShardedRingBuffer.
+//
 template <
+    typename Buffer,
     size_t MaxRecordSize = 256,
-    typename Encoders = jetlog::ParamEncoders_32_And_Float
+    typename Encoders = jetlog::ParamEncoders_32_And_Float,
+    bool InternStrings = false,
+    uint8_t MaxLevel = level::verbose,
+    size_t MaxTagFilters = 0,
+    typename Clock = jetlog::VirtualClock,
+    bool DeltaTime = false,
+    bool Sequence = false
 >
-class Writer {
+class BasicWriter {
+    using TimeType = typename Clock::Type;
+
+    static_assert(etl::is_same<TimeType, uint32_t>::value || etl::is_same<TimeType, uint64_t>::value,
+        "Clock type must be uint32_t or uint64_t");
+
 public:
-    explicit Writer(jetlog::IRingBuffer& buf) : ringBuffer{buf} {}
+    explicit BasicWriter(Buffer& buf) : ringBuffer{buf} {}
 
+    // Returns false if record was not written (filtered out, or no space).
     template<typename... Args>
     auto push(const char* tag, uint8_t level, const char* message, const Args&... msgArgs) -> bool {
-        // record should be vector, but we use string to control overflow
-        etl::string<MaxRecordSize> record{};
-        record.clear();
+        // Check filters before any encoding, to make disabled calls cheap
+        if (!isEnabled(tag, level)) { return false; }
 
-        Encoders::write(getTime(), record);
-        Encoders::write(tag, record);
-        Encoders::write(level, record);
-        Encoders::write(message, record);
+        TimeType timestamp{now()};
 
-        int dummy[] = { 0, (Encoders::write(jetlog::decayLiteralArg(msgArgs), record), 0)... };
-        (void)dummy;
+        if (DeltaTime) {
+            // Full time goes to the first record of each period, others
+            // store only low bits. 0 is reserved for "not synced".
+            uint32_t epoch{static_cast<uint32_t>(timestamp >> 16) + 1};
 
-        bool size_ok = !record.is_truncated();
+            if (syncedEpoch.load(etl::memory_order_acquire) == epoch) {
+                return pushWithTime(static_cast<uint16_t>(timestamp), tag, level, message, msgArgs...);
+            }
 
-        if (!size_ok) {
-            // If data too big, write truncated stub
-            record.clear();
-            Encoders::write(getTime(), record);
-            Encoders::write(tag, record);
-            Encoders::write(level, record);
-            static const char* stub = "[TRUNCATED]";
-            Encoders::write(stub, record);
+            if (!pushWithTime(timestamp, tag, level, message, msgArgs...)) { return false; }
+
+            // Set after commit. Writers, which see it, place records after
+            // the synced one.
+            syncedEpoch.store(epoch, etl::memory_order_release);
+            return true;
+        }
+
+        return pushWithTime(timestamp, tag, level, message, msgArgs...);
+    }
+
+    // The same, with level known at compile time. Calls with level above
+    // MaxLevel are compiled to nothing.
+    template<uint8_t Level, typename... Args>
+    auto push(const char* tag, const char* message, const Args&... msgArgs)
+        -> typename etl::enable_if<(Level <= MaxLevel), bool>::type
+    {
+        return push(tag, Level, message, msgArgs...);
+    }
+
+    template<uint8_t Level, typename... Args>
+    auto push(const char*, const char*, const Args&...)
+        -> typename etl::enable_if<(Level > MaxLevel), bool>::type
+    {
+        return false;
+    }
+
+    // Runtime threshold, records with higher level are dropped. Can be
+    // changed at any time.
+    void setLevel(uint8_t level) {
+        threshold.store(etl::min(level, MaxLevel), etl::memory_order_relaxed);
+    }
+
+    auto getLevel() const -> uint8_t {
+        return threshold.load(etl::memory_order_relaxed);
+    }
+
+    // Override threshold for specific tag. Returns false if table is full.
+    // Not thread-safe, call on init, before logging starts.
+    auto setTagLevel(const char* tag, uint8_t level) -> bool {
+        level = etl::min(level, MaxLevel);
+
+        for (size_t i{0}; i < tagFiltersCount; i++) {
+            if (strcmp(tagFilters[i].tag, tag) == 0) {
+                tagFilters[i].level = level;
+                return true;
+            }
         }
 
-        return ringBuffer.writeRecord(reinterpret_cast<const uint8_t*>(record.data()), record.size()) &&
-            size_ok;
+        if (tagFiltersCount >= MaxTagFilters) { return false; }
+
+        tagFilters[tagFiltersCount++] = { tag, level };
+        return true;
     }
 
+    // Can be used to skip expensive params preparation
+    auto isEnabled(const char* tag, uint8_t level) const -> bool {
+        if (MaxTagFilters > 0 && tagFiltersCount > 0) {
+            for (size_t i{0}; i < tagFiltersCount; i++) {
+                if (strcmp(tagFilters[i].tag, tag) == 0) { return level <= tagFilters[i].level; }
+            }
+        }
+
+        return level <= threshold.load(etl::memory_order_relaxed);
+    }
+
+    // Used with default clock only
     virtual auto getTime() -> uint32_t {
         return etl::numeric_limits<uint32_t>::max();
     }
 
+    auto getClock() -> Clock& { return clock; }
+
 private:
-    jetlog::IRingBuffer& ringBuffer;
-};
+    auto now() -> TimeType { return now(etl::is_same<Clock, VirtualClock>{}); }
+    auto now(etl::true_type) -> TimeType { return getTime(); }
+    auto now(etl::false_type) -> TimeType { return clock.now(); }
+
+    template<typename TimeT, typename... Args>
+    auto pushWithTime(TimeT timestamp, const char* tag, uint8_t level, const char* message, const Args&... msgArgs) -> bool {
+        return pushSized(timestamp, textArg(tag), level, textArg(message),
+            jetlog::sizedArg(jetlog::decayLiteralArg(msgArgs))...);
+    }
+
+    template<typename TimeT, typename Text, typename... Args>
+    auto pushSized(TimeT timestamp, const Text& tag, uint8_t level, const Text& message, const Args&... msgArgs) -> bool {
+        // Numbered before allocation, so failed writes leave a gap too
+        uint32_t seq{Sequence ? ringBuffer.nextSequence() : 0};
+
+        // Calculate exact record size first, to allocate space in ring buffer
+        // and encode data directly into it, without intermediate copy.
+        auto size = recordSize(timestamp, seq, tag, level, message, msgArgs...);
 
+        if (size > MaxRecordSize) {
+            // If data too big, write truncated stub
+            auto stub = textArg("[TRUNCATED]");
+            writeRecord(recordSize(timestamp, seq, tag, level, stub), timestamp, seq, tag, level, stub);
+            return false;
+        }
+
+        return writeRecord(size, timestamp, seq, tag, level, message, msgArgs...);
+    }
+
+    // Adapter to write strings with encoders from list
+    struct TextEncoder {
+        static constexpr size_t fixedSize = 0;
+
+        static auto dynamicSize(const SizedCString& value) -> size_t { return Encoders::size(value); }
+
+        template <typename TOUT>
+        static void write(const SizedCString& value, TOUT& out) { Encoders::write(value, out); }
+    };
+
+    using StringEncoder = typename etl::conditional<InternStrings,
+        typename Encoders::StrRefEncoder,
+        TextEncoder
+    >::type;
+
+    // Tag and message, as StringEncoder takes them (interned ones need no length)
+    static auto textArg(const char* text) -> typename etl::conditional<InternStrings, const char*, SizedCString>::type {
+        return textArg(text, etl::integral_constant<bool, InternStrings>{});
+    }
+    static auto textArg(const char* text, etl::true_type) -> const char* { return text; }
+    static auto textArg(const char* text, etl::false_type) -> SizedCString { return jetlog::sizedArg(text); }
+
+    template<typename TimeT>
+    using TimeEncoder = typename Encoders::template TimeEncoder<TimeT>;
+
+    using SequenceEncoder = typename Encoders::SequenceEncoder;
+
+    template<typename TimeT, typename Text, typename... Args>
+    static auto recordSize(TimeT timestamp, uint32_t seq, const Text& tag, uint8_t level, const Text& message, const Args&... msgArgs) -> size_t {
+        return TimeEncoder<TimeT>::fixedSize + TimeEncoder<TimeT>::dynamicSize(timestamp) +
+            (Sequence ? SequenceEncoder::fixedSize + SequenceEncoder::dynamicSize(seq) : 0) +
+            Encoders::size(level, msgArgs...) +
+            StringEncoder::fixedSize + StringEncoder::dynamicSize(tag) +
+            StringEncoder::fixedSize + StringEncoder::dynamicSize(message);
+    }
+
+    template<typename TimeT, typename Text, typename... Args>
+    auto writeRecord(size_t size, TimeT timestamp, uint32_t seq, const Text& tag, uint8_t level, const Text& message, const Args&... msgArgs) -> bool {
+        RecordSpan span{};
+        if (!ringBuffer.reserveRecord(size, span, level == level::error)) { return false; }
+
+        RecordWriter out{span};
+
+        TimeEncoder<TimeT>::write(timestamp, out);
+        StringEncoder::write(tag, out);
+        Encoders::write(level, out);
+        // Goes before message, reader detects it by type (message is string)
+        if (Sequence) { SequenceEncoder::write(seq, out); }
+        StringEncoder::write(message, out);
+
+        int dummy[] = { 0, (Encoders::write(msgArgs, out), 0)... };
+        (void)dummy;
+
+        ringBuffer.commitRecord(span);
+        return true;
+    }
+
+    struct TagFilter {
+        const char* tag;
+        uint8_t level;
+    };
+
+    Buffer& ringBuffer;
+    Clock clock{};
 
+    etl::atomic<uint8_t> threshold{MaxLevel};
+    TagFilter tagFilters[MaxTagFilters > 0 ? MaxTagFilters : 1]{};
+    size_t tagFiltersCount{0};
+    etl::atomic<uint32_t> syncedEpoch{0};
+};
+
+// Writer for any ring buffer. See BasicWriter for params description.
 template <
     size_t MaxRecordSize = 256,
-    typename Decoders = jetlog::ParamDecoders_32_And_Float
+    typename Encoders = jetlog::ParamEncoders_32_And_Float,
+    bool InternStrings = false,
+    uint8_t MaxLevel = level::verbose,
+    size_t MaxTagFilters = 0,
+    typename Clock = jetlog::VirtualClock,
+    bool DeltaTime = false,
+    bool Sequence = false
 >
-class Reader {
+using Writer = BasicWriter<jetlog::IRingBuffer,
+    MaxRecordSize, Encoders, InternStrings, MaxLevel, MaxTagFilters, Clock, DeltaTime, Sequence>;
+
+
+//
+// Formatters output. Small pieces (header, numbers) are formatted into
+// `buffer()` and passed out with `commit()`. Text is passed with `write()`.
+//
+
+// Appends all to string, `buffer()` is the string itself
+class StringTarget {
 public:
-    explicit Reader(jetlog::IRingBuffer& buf) : ringBuffer{buf} {}
+    explicit StringTarget(etl::istring& out) : output{out} {}
 
-    auto pull(etl::istring& output) -> bool {
-        etl::vector<uint8_t, MaxRecordSize> record;
-        if (!ringBuffer.readRecord(record)) { return false; }
+    void write(const etl::string_view& text) { output.append(text.begin(), text.end()); }
+    auto buffer() -> etl::istring& { return output; }
+    void commit() {}
+    auto isTruncated() const -> bool { return output.is_truncated(); }
 
-        int32_t offset = 0;
+private:
+    etl::istring& output;
+};
 
-        if (!IDecoder::isAvailableAt(record, offset)) { return false; }
-        auto timestamp = IDecoder::getAsNum<uint32_t>(record, offset);
-        offset = IDecoder::getNextOffset(record, offset);
+// Passes all to sink, via small buffer. Numbers with binary format take up
+// to 66 chars, buffer has a bit more. Longer parts (tags, padding) are passed
+// separately, see commitReplacing() and commitPadded().
+class SinkTarget {
+public:
+    explicit SinkTarget(ISink& out) : sink{out} {}
 
-        if (!IDecoder::isAvailableAt(record, offset)) { return false; }
-        auto tag = IDecoder::getAsStringView(record, offset);
-        offset = IDecoder::getNextOffset(record, offset);
+    void write(const etl::string_view& text) {
+        commit();
+        sink.write(text.data(), text.size());
+    }
 
-        if (!IDecoder::isAvailableAt(record, offset)) { return false; }
-        auto level = IDecoder::getAsNum<uint8_t>(record, offset);
-        offset = IDecoder::getNextOffset(record, offset);
+    auto buffer() -> etl::istring& { return scratch; }
 
-        if (!IDecoder::isAvailableAt(record, offset)) { return false; }
-        auto tokenizer = StringTokenizer(IDecoder::getAsStringView(record, offset));
-        offset = IDecoder::getNextOffset(record, offset);
+    void commit() {
+        if (scratch.empty()) { return; }
+        sink.write(scratch.data(), scratch.size());
+        scratch.clear();
+    }
 
-        writeLogHeader(output, timestamp, tag, level);
+    // Pass out buffer, with `text` in place of the first `marker` char
+    void commitReplacing(char marker, const etl::string_view& text) {
+        size_t pos{etl::string_view(scratch.data(), scratch.size()).find(marker)};
+        if (pos == etl::string_view::npos) {
+            commit();
+            return;
+        }
 
-        for (const auto& token : tokenizer) {
-            if (token.is_placeholder) {
-                if (Decoders::format(record, offset, output, token.text)) {
-                    offset = IDecoder::getNextOffset(record, offset);
-                } else {
-                    // no params left => write placeholder source
-                    output.append(token.text.begin(), token.text.end());
-                }
-            } else {
-                output.append(token.text.begin(), token.text.end());
-            }
+        sink.write(scratch.data(), pos);
+        sink.write(text.data(), text.size());
+        sink.write(scratch.data() + pos + 1, scratch.size() - pos - 1);
+        scratch.clear();
+    }
+
+    // Pass out buffer, padded on the left with `fill` up to `width` chars
+    void commitPadded(size_t width, char fill) {
+        char padding[16];
+        etl::fill_n(padding, sizeof(padding), fill);
+
+        for (size_t size{scratch.size()}; size < width;) {
+            size_t chunk{etl::min(width - size, sizeof(padding))};
+            sink.write(padding, chunk);
+            size += chunk;
+        }
+        commit();
+    }
+
+    auto isTruncated() const -> bool { return false; }
+
+private:
+    ISink& sink;
+    etl::string<80> scratch;
+};
+
+
+//
+// Converts binary records to text lines. Used by Reader, and can be used
+// separately, to decode records exported to host.
+//
+// FormatCache - cache of parsed format strings, to speed up formatting of
+// repeated messages. For example `jetlog::FormatCache<64>`. Disabled by
+// default, to save memory.
+//
+template <
+    typename Decoders = jetlog::ParamDecoders_32_And_Float,
+    typename FormatCache = jetlog::NoFormatCache
+>
+class RecordFormatter {
+    using Helpers = typename Decoders::Helpers;
+
+public:
+    auto formatRecord(const RecordData& record, etl::istring& output) -> bool {
+        StringTarget target{output};
+        return formatTo(record, target);
+    }
+
+    // The same, streamed to sink, without line buffer
+    auto formatRecord(const RecordData& record, ISink& sink) -> bool {
+        SinkTarget target{sink};
+        bool result{formatTo(record, target)};
+        target.commit();
+        return result;
+    }
+
+    //
+    // Writes "N records lost" line, if records before this one are missing
+    // (writer must have `Sequence` option). Returns false if nothing lost.
+    // Call before formatRecord(), and then format the record as usual.
+    //
+    auto formatLost(const RecordData& record, etl::istring& output) -> bool {
+        uint32_t offset{0};
+
+        // Skip timestamp, tag and level
+        for (int i = 0; i < 3; i++) {
+            if (!Helpers::isAvailableAt(record, offset)) { return false; }
+            offset = Helpers::getNextOffset(record, offset);
         }
 
+        if (!hasSequenceAt(record, offset)) { return false; }
+
+        auto seq = Helpers::template getAsNum<uint32_t>(record, offset);
+        auto lost = sequenceTracker.lostBefore(seq);
+        if (lost == 0) { return false; }
+
+        writeLostRecords(output, lost);
+        sequenceTracker.skipTo(seq);
+        timestampDecoder.reset();
         return true;
     }
 
-    virtual void writeLogHeader(etl::istring& output, uint32_t timestamp, const etl::string_view& tag, uint8_t level) {
+    auto formatLost(const RecordData& record, ISink& sink) -> bool {
+        SinkTarget target{sink};
+        bool result{formatLost(record, target.buffer())};
+        target.commit();
+        return result;
+    }
+
+    //
+    // Writes "N records lost" line for small gap, held back to let late
+    // records fill it (see SequenceTracker). Call when there are no more
+    // records to read. Returns false if nothing lost.
+    //
+    auto formatPendingLost(etl::istring& output) -> bool {
+        auto lost = sequenceTracker.pending();
+        if (lost == 0) { return false; }
+
+        writeLostRecords(output, lost);
+        sequenceTracker.clearPending();
+        return true;
+    }
+
+    auto formatPendingLost(ISink& sink) -> bool {
+        SinkTarget target{sink};
+        bool result{formatPendingLost(target.buffer())};
+        target.commit();
+        return result;
+    }
+
+    // Call if records were evicted before the next one. Delta timestamps are
+    // not restored until the next full time, and sequence gap is reported
+    // at once.
+    void markGap() {
+        timestampDecoder.reset();
+        sequenceTracker.markEvicted();
+    }
+
+    virtual void writeLostRecords(etl::istring& output, uint32_t count) {
+        writeLogHeader(output, TimestampDecoder::NoTime, {}, level::warn);
+        etl::to_string(count, output, true);
+        output.append(" records lost");
+    }
+
+    // For sink output, long `tag` is passed as a marker char, and replaced
+    // with text after (keep it as is, if tag is written)
+    virtual void writeLogHeader(etl::istring& output, uint64_t timestamp, const etl::string_view& tag, uint8_t level) {
         output.append(level2str(level));
 
-        if (timestamp != etl::numeric_limits<uint32_t>::max()) {
+        if (timestamp != TimestampDecoder::NoTime) {
             output.append(" (");
             etl::to_string(timestamp, output, true);
             output.append(")");
@@ -158,8 +506,560 @@ public:
         }
     }
 
+protected:
+    // Fields before params
+    struct RecordHeader {
+        uint64_t timestamp;
+        etl::string_view tag;
+        uint8_t level;
+        etl::string_view message;
+        uint32_t paramsOffset;
+    };
+
+    template <typename Target>
+    auto formatTo(const RecordData& record, Target& out) -> bool {
+        RecordHeader header{};
+        if (!parseHeader(record, header)) { return false; }
+
+        const auto& message = header.message;
+        int32_t offset = header.paramsOffset;
+
+        writeHeader(header, out);
+
+        const auto* cached = formatCache.get(message);
+
+        if (cached) {
+            for (size_t i{0}; i < cached->segments_count; i++) {
+                const auto& segment = cached->segments[i];
+                auto text = message.substr(segment.offset, segment.length);
+
+                if (segment.is_placeholder && formatParam(record, offset, out, segment.spec)) {
+                    offset = Helpers::getNextOffset(record, offset);
+                } else {
+                    out.write(text);
+                }
+            }
+            return true;
+        }
+
+        for (const auto& token : StringTokenizer(message)) {
+            if (token.is_placeholder) {
+                if (formatParam(record, offset, out, token.text)) {
+                    offset = Helpers::getNextOffset(record, offset);
+                } else {
+                    // no params left => write placeholder source
+                    out.write(token.text);
+                }
+            } else {
+                out.write(token.text);
+            }
+        }
+
+        return true;
+    }
+
+    void writeHeader(const RecordHeader& header, StringTarget& out) {
+        writeLogHeader(out.buffer(), header.timestamp, header.tag, header.level);
+    }
+
+    // Long tag does not fit sink buffer. Header is formatted with a marker
+    // instead, and tag is passed in its place.
+    void writeHeader(const RecordHeader& header, SinkTarget& out) {
+        static constexpr char TagMarker = '\x1F';
+
+        if (header.tag.length() <= out.buffer().capacity() / 2) {
+            writeLogHeader(out.buffer(), header.timestamp, header.tag, header.level);
+            out.commit();
+            return;
+        }
+
+        writeLogHeader(out.buffer(), header.timestamp, etl::string_view(&TagMarker, 1), header.level);
+        out.commitReplacing(TagMarker, header.tag);
+    }
+
+    template <typename Spec>
+    static auto formatParam(const RecordData& record, uint32_t offset, StringTarget& out, const Spec& spec) -> bool {
+        return Decoders::format(record, offset, out.buffer(), spec);
+    }
+
+    template <typename Spec>
+    static auto formatParam(const RecordData& record, uint32_t offset, SinkTarget& out, const Spec& spec) -> bool {
+        // Strings can be long, stream those as is
+        if (isString(record, offset)) {
+            out.write(Helpers::getAsStringView(record, offset));
+            return true;
+        }
+
+        // Width can be bigger than sink buffer, integers are padded on output
+        if (isInteger(record, offset)) {
+            auto parsed = parseSpec(spec);
+            uint32_t width{parsed.get_width()};
+
+            if (width > 0) {
+                bool result{Decoders::format(record, offset, out.buffer(), parsed.width(0))};
+                out.commitPadded(width, parsed.get_fill());
+                return result;
+            }
+        }
+
+        bool result{Decoders::format(record, offset, out.buffer(), spec)};
+        out.commit();
+        return result;
+    }
+
+    static auto parseSpec(const etl::format_spec& spec) -> etl::format_spec { return spec; }
+
+    static auto parseSpec(const etl::string_view& text) -> etl::format_spec {
+        etl::format_spec spec{};
+        FormatParser::parse_format(text, 0, spec);
+        return spec;
+    }
+
+    static auto isInteger(const RecordData& record, uint32_t offset) -> bool {
+        return Helpers::isAvailableAt(record, offset) &&
+            Helpers::readHeader(record, offset).typeId <= static_cast<uint8_t>(DataType::U64);
+    }
+
+    static auto isString(const RecordData& record, uint32_t offset) -> bool {
+        if (!Helpers::isAvailableAt(record, offset)) { return false; }
+
+        auto type = Helpers::readHeader(record, offset).typeId;
+        return type == static_cast<uint8_t>(DataType::Str) || type == static_cast<uint8_t>(DataType::StrRef);
+    }
+
+    // Updates timestamp and sequence state, call once per record
+    auto parseHeader(const RecordData& record, RecordHeader& header) -> bool {
+        uint32_t offset{0};
+
+        if (!Helpers::isAvailableAt(record, offset)) { return false; }
+        header.timestamp = timestampDecoder.template decode<Helpers>(record, offset);
+        offset = Helpers::getNextOffset(record, offset);
+
+        if (!Helpers::isAvailableAt(record, offset)) { return false; }
+        header.tag = Helpers::getAsStringView(record, offset);
+        offset = Helpers::getNextOffset(record, offset);
+
+        if (!Helpers::isAvailableAt(record, offset)) { return false; }
+        header.level = Helpers::template getAsNum<uint8_t>(record, offset);
+        offset = Helpers::getNextOffset(record, offset);
+
+        if (hasSequenceAt(record, offset)) {
+            sequenceTracker.accept(Helpers::template getAsNum<uint32_t>(record, offset));
+            offset = Helpers::getNextOffset(record, offset);
+        }
+
+        if (!Helpers::isAvailableAt(record, offset)) { return false; }
+        header.message = Helpers::getAsStringView(record, offset);
+        header.paramsOffset = Helpers::getNextOffset(record, offset);
+
+        return true;
+    }
+
+    // Timestamp and sequence state, to roll back after formatting a record,
+    // which turned out to be overwritten. Format cache entry, parsed from
+    // such record, is dropped.
+    struct State {
+        TimestampDecoder timestampDecoder;
+        SequenceTracker sequenceTracker;
+        uint32_t cacheFills;
+    };
+
+    auto saveState() const -> State { return {timestampDecoder, sequenceTracker, formatCache.fills()}; }
+
+    void restoreState(const State& state) {
+        timestampDecoder = state.timestampDecoder;
+        sequenceTracker = state.sequenceTracker;
+        formatCache.rollback(state.cacheFills);
+    }
+
+    // Check if record has interned strings (pointers)
+    static auto hasStrRefs(const RecordData& record) -> bool {
+        uint32_t offset{0};
+
+        while (Helpers::isAvailableAt(record, offset)) {
+            if (Helpers::readHeader(record, offset).typeId == static_cast<uint8_t>(DataType::StrRef)) {
+                return true;
+            }
+            offset = Helpers::getNextOffset(record, offset);
+        }
+        return false;
+    }
+
+private:
+    // Sequence number goes between level and message (always a string)
+    static auto hasSequenceAt(const RecordData& record, uint32_t offset) -> bool {
+        return Helpers::isAvailableAt(record, offset) && !isString(record, offset);
+    }
+
+    FormatCache formatCache{};
+    TimestampDecoder timestampDecoder{};
+    SequenceTracker sequenceTracker{};
+};
+
+
+//
+// Converts binary records to JSON lines, for log collectors. Message is not
+// formatted, params are passed as array of typed values instead:
+//
+//   {"ts":1200,"level":"info","tag":"net","msg":"Sent {} to {}","args":[512,"srv"]}
+//
+// Timestamp is omitted if not available. Not representable values (NaN,
+// unknown types) are written as null. Lost records (see Writer `Sequence`
+// option) are reported as `{"lost":12}`.
+//
+// Output string must fit the whole line, otherwise record is reported as
+// broken (cut JSON is not usable).
+//
+template <
+    typename Decoders = jetlog::ParamDecoders_32_And_Float,
+    typename FormatCache = jetlog::NoFormatCache
+>
+class JsonFormatter : public RecordFormatter<Decoders, FormatCache> {
+    using Base = RecordFormatter<Decoders, FormatCache>;
+    using Helpers = typename Decoders::Helpers;
+
+public:
+    auto formatRecord(const RecordData& record, etl::istring& output) -> bool {
+        StringTarget target{output};
+        return formatTo(record, target);
+    }
+
+    // The same, streamed to sink, without line buffer
+    auto formatRecord(const RecordData& record, ISink& sink) -> bool {
+        SinkTarget target{sink};
+        bool result{formatTo(record, target)};
+        target.commit();
+        return result;
+    }
+
+    void writeLostRecords(etl::istring& output, uint32_t count) override {
+        output.append("{\"lost\":");
+        etl::to_string(count, output, true);
+        output.append("}");
+    }
+
+    virtual auto levelName(uint8_t level) -> const char* {
+        switch (level) {
+            case level::error: return "error";
+            case level::warn: return "warn";
+            case level::info: return "info";
+            case level::debug: return "debug";
+            case level::verbose: return "verbose";
+            default: return "unknown";
+        }
+    }
+
+private:
+    template <typename Target>
+    auto formatTo(const RecordData& record, Target& out) -> bool {
+        typename Base::RecordHeader header{};
+        if (!this->parseHeader(record, header)) { return false; }
+
+        auto& buffer = out.buffer();
+        buffer.append("{");
+
+        if (header.timestamp != TimestampDecoder::NoTime) {
+            buffer.append("\"ts\":");
+            etl::to_string(header.timestamp, buffer, true);
+            buffer.append(",");
+        }
+
+        buffer.append("\"level\":\"");
+        buffer.append(levelName(header.level));
+        buffer.append("\",\"tag\":");
+        appendString(out, header.tag);
+        buffer.append(",\"msg\":");
+        appendString(out, header.message);
+        buffer.append(",\"args\":[");
+
+        uint32_t offset{header.paramsOffset};
+
+        while (Helpers::isAvailableAt(record, offset)) {
+            if (offset != header.paramsOffset) { buffer.append(","); }
+            appendValue(record, offset, out);
+            offset = Helpers::getNextOffset(record, offset);
+        }
+
+        buffer.append("]}");
+        out.commit();
+
+        // Cut JSON is not usable
+        return !out.isTruncated();
+    }
+
+    // Quoted and escaped JSON string
+    template <typename Target>
+    static void appendString(Target& out, const etl::string_view& text) {
+        static const char hex[] = "0123456789abcdef";
+
+        auto& buffer = out.buffer();
+        buffer.push_back('"');
+
+        for (char c : text) {
+            auto code = static_cast<uint8_t>(c);
+
+            // Room for the longest escape sequence and closing quote
+            if (buffer.available() < 7) { out.commit(); }
+
+            if (c == '"' || c == '\\') {
+                buffer.push_back('\\');
+                buffer.push_back(c);
+            } else if (code < 0x20) {
+                switch (c) {
+                    case '\n': buffer.append("\\n"); break;
+                    case '\r': buffer.append("\\r"); break;
+                    case '\t': buffer.append("\\t"); break;
+                    default:
+                        buffer.append("\\u00");
+                        buffer.push_back(hex[code >> 4]);
+                        buffer.push_back(hex[code & 0xF]);
+                }
+            } else {
+                buffer.push_back(c);
+            }
+        }
+
+        buffer.push_back('"');
+        out.commit();
+    }
+
+    template <typename Target>
+    static void appendValue(const RecordData& record, uint32_t offset, Target& out) {
+        if (Base::isString(record, offset)) {
+            appendString(out, Helpers::getAsStringView(record, offset));
+            return;
+        }
+
+        // Numbers are written by decoders as is
+        out.commit();
+        auto& buffer = out.buffer();
+        size_t start{buffer.size()};
+        Decoders::format(record, offset, buffer);
+
+        if (!isNumber(buffer, start)) {
+            buffer.resize(start);
+            buffer.append("null");
+        }
+    }
+
+    // Rough check, enough to filter out "nan", "inf" and unknown types
+    static auto isNumber(const etl::istring& text, size_t start) -> bool {
+        if (start >= text.size()) { return false; }
+
+        size_t i{text[start] == '-' ? start + 1 : start};
+        if (i >= text.size() || text[i] < '0' || text[i] > '9') { return false; }
+
+        for (; i < text.size(); i++) {
+            char c = text[i];
+            bool valid = (c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-';
+            if (!valid) { return false; }
+        }
+        return true;
+    }
+};
+
+
+//
+// Formatter - RecordFormatter (text lines) or JsonFormatter.
+//
+template <
+    size_t MaxRecordSize = 256,
+    typename Decoders = jetlog::ParamDecoders_32_And_Float,
+    typename FormatCache = jetlog::NoFormatCache,
+    template <typename, typename> class Formatter = jetlog::RecordFormatter
+>
+class Reader : public Formatter<Decoders, FormatCache> {
+public:
+    explicit Reader(jetlog::IRingBuffer& buf) : ringBuffer{buf}, resolveRefs{!buf.isShared()} {}
+
+    auto pull(etl::istring& output) -> bool {
+        ReadResult result;
+        while ((result = formatNext(output)) == ReadResult::Lost) {}
+
+        if (result == ReadResult::Empty) { return this->formatPendingLost(output); }
+        return result == ReadResult::Formatted || result == ReadResult::Gap;
+    }
+
+    //
+    // Read all available records in one pass (up to `max_records`), and call
+    // `onLine(const etl::istring&)` for each one. `output` is used as line
+    // buffer, and is cleared before each record. Returns number of records.
+    // "Records lost" lines are passed to `onLine` too, but not counted.
+    //
+    // Records are copied out of buffer and validated before formatting, and
+    // removed from buffer after all are processed.
+    //
+    template<typename F>
+    auto drain(etl::istring& output, F&& onLine,
+        size_t max_records = etl::numeric_limits<size_t>::max()) -> size_t
+    {
+        auto count = readBatch([this, &output, &onLine](const RecordData& record) {
+            output.clear();
+            if (this->formatLost(record, output)) {
+                onLine(output);
+                output.clear();
+            }
+            if (this->formatRecord(record, output)) { onLine(output); }
+        }, max_records);
+
+        output.clear();
+        if (this->formatPendingLost(output)) { onLine(output); }
+        return count;
+    }
+
+    //
+    // Streaming variants. Lines are written to `sink` with "\n" at the end,
+    // so long texts and strings are not limited by line buffer size. Written
+    // data can't be taken back, so records are always copied and validated
+    // before formatting.
+    //
+    auto pull(ISink& sink) -> bool {
+        bool formatted{false};
+        auto count = readBatch([this, &sink, &formatted](const RecordData& record) {
+            formatted = writeLines(record, sink);
+        }, 1);
+
+        if (count == 0) { return writePendingLost(sink); }
+        return formatted;
+    }
+
+    auto drain(ISink& sink, size_t max_records = etl::numeric_limits<size_t>::max()) -> size_t {
+        auto count = readBatch([this, &sink](const RecordData& record) {
+            writeLines(record, sink);
+        }, max_records);
+
+        writePendingLost(sink);
+        sink.flush();
+        return count;
+    }
+
+private:
+    enum class ReadResult { Empty, Lost, Broken, Gap, Formatted };
+
+    using RecordCopy = etl::vector<uint8_t, MaxRecordSize>;
+
+    // Passes records of batch read to `onRecord(const RecordData&)`
+    template<typename F>
+    class BatchConsumer : public IRecordConsumer {
+    public:
+        BatchConsumer(Reader& r, F& f) : reader{r}, onRecord{f} {}
+
+        void onGap() override { reader.markGap(); }
+
+        auto consume(const etl::ivector<uint8_t>& data) -> bool override {
+            onRecord(RecordData{data, reader.resolveRefs});
+            return true;
+        }
+
+    private:
+        Reader& reader;
+        F& onRecord;
+    };
+
+    template<typename F>
+    auto readBatch(F&& onRecord, size_t max_records) -> size_t {
+        RecordCopy record;
+        BatchConsumer<F> consumer{*this, onRecord};
+
+        return ringBuffer.readRecords(record, consumer, max_records);
+    }
+
+    // "Records lost" line (if any) and the record line
+    auto writeLines(const RecordData& record, ISink& sink) -> bool {
+        if (this->formatLost(record, sink)) { sink.write("\n", 1); }
+
+        bool formatted{this->formatRecord(record, sink)};
+
+        // Part of broken record may be written already, end the line anyway
+        sink.write("\n", 1);
+        return formatted;
+    }
+
+    auto writePendingLost(ISink& sink) -> bool {
+        if (!this->formatPendingLost(sink)) { return false; }
+
+        sink.write("\n", 1);
+        return true;
+    }
+
+    // Drop text of a record, which turned out to be lost
+    static void restoreOutput(etl::istring& output, size_t size, bool truncated) {
+        output.resize(size);
+        if (!truncated) { output.clear_truncated(); }
+    }
+
+    static void copyRecord(const RecordView& view, RecordCopy& copy) {
+        copy.resize(etl::min(view.size(), copy.capacity()));
+
+        size_t first{etl::min(view.first_size, copy.size())};
+        etl::copy_n(view.first, first, copy.data());
+        etl::copy_n(view.second, copy.size() - first, copy.data() + first);
+    }
+
+    //
+    // Format the oldest record and remove it. Records are formatted in place,
+    // without copy. Only wrapped ones (at buffer end) and ones with interned
+    // strings are copied, to validate before use. In place data may be
+    // overwritten while formatting, so pointers from it are never followed,
+    // and decoding state is rolled back if record is lost.
+    //
+    // If records before it were lost, returns "records lost" line instead,
+    // and keeps the record for the next call.
+    //
+    auto formatNext(etl::istring& output) -> ReadResult {
+        RecordView view{};
+        if (!ringBuffer.viewRecord(view)) { return ReadResult::Empty; }
+        if (view.follows_gap) { this->markGap(); }
+
+        size_t output_size{output.size()};
+        bool output_truncated{output.is_truncated()};
+        auto state = this->saveState();
+        RecordCopy copy;
+
+        bool in_place{view.second_size == 0 && !this->hasStrRefs(RecordData{view.first, view.first_size, false})};
+
+        if (!in_place) { copyRecord(view, copy); }
+
+        RecordData record{in_place ? RecordData{view.first, view.first_size, false} : RecordData{copy, resolveRefs}};
+
+        if (this->formatLost(record, output)) {
+            // Make sure sequence number was not read from overwritten record
+            RecordView current{};
+            if (ringBuffer.viewRecord(current) && current.index == view.index) { return ReadResult::Gap; }
+
+            this->restoreState(state);
+            this->markGap();
+            restoreOutput(output, output_size, output_truncated);
+            return ReadResult::Lost;
+        }
+
+        bool formatted{false};
+
+        if (in_place) {
+            formatted = this->formatRecord(record, output);
+
+            // Overwritten while formatting, result is garbage
+            if (!ringBuffer.consumeRecord(view)) {
+                this->restoreState(state);
+                this->markGap();
+                restoreOutput(output, output_size, output_truncated);
+                return ReadResult::Lost;
+            }
+        } else {
+            if (!ringBuffer.consumeRecord(view)) {
+                this->markGap();
+                return ReadResult::Lost;
+            }
+
+            formatted = this->formatRecord(record, output);
+        }
+
+        return formatted ? ReadResult::Formatted : ReadResult::Broken;
+    }
+
 private:
     jetlog::IRingBuffer& ringBuffer;
+    bool resolveRefs;
 };
 
 } // namespace jetlog
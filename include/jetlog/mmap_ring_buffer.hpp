@@ -0,0 +1,176 @@
+#pragma once
+
+//
+// Ring buffer in memory-mapped file, for POSIX hosts (not included by
+// default). Several processes can map the same file and write/read records,
+// with the same lock-free protocol as RingBuffer, without syscalls.
+//
+// One process (usually the reader/collector) creates the file with desired
+// size, others attach to it:
+//
+//   jetlog::MmapRingBuffer<> ringBuffer("/dev/shm/app.log", 1024 * 1024);
+//   jetlog::MmapRingBuffer<> ringBuffer("/dev/shm/app.log");
+//
+// Data survives restart of processes (and host restart, if file is not on
+// tmpfs). Waiter (setWaiter()) and stats work within one process only.
+//
+// If writer process dies between reserve and commit, new records are not
+// published anymore. Collector should call unlockStalled() periodically, to
+// recover.
+//
+// Don't use `InternStrings` writers and `static_str` params here. Pointers
+// are valid only in writer process. Readers don't follow those and print
+// "<ref>" instead.
+//
+
+#include "private/persistent_ring_buffer.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jetlog {
+
+// Owns file mapping. Separate class, to be constructed before ring buffer.
+class MmapFile {
+public:
+    MmapFile(const char* path, size_t size) {
+        int fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) { return; }
+
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) != size) {
+            // New file, or size changed => buffer will be formatted
+            if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+                close(fd);
+                return;
+            }
+        }
+
+        map(fd, size);
+    }
+
+    explicit MmapFile(const char* path) {
+        int fd = open(path, O_RDWR);
+        if (fd < 0) { return; }
+
+        struct stat st{};
+        if (fstat(fd, &st) != 0) {
+            close(fd);
+            return;
+        }
+
+        map(fd, static_cast<size_t>(st.st_size));
+
+        // Don't touch file without valid buffer
+        if (isMapped() && !MemoryStorage(mapped, mapped_size).isValid()) {
+            munmap(mapped, mapped_size);
+            mapped = MAP_FAILED;
+        }
+    }
+
+    ~MmapFile() {
+        if (mapped != MAP_FAILED) { munmap(mapped, mapped_size); }
+    }
+
+    MmapFile(const MmapFile&) = delete;
+    auto operator=(const MmapFile&) -> MmapFile& = delete;
+
+    auto isMapped() const -> bool { return mapped != MAP_FAILED; }
+
+    // If mapping failed, small dummy block is returned, to keep ring buffer
+    // in valid state.
+    auto memory() -> void* { return isMapped() ? mapped : static_cast<void*>(dummy); }
+    auto size() const -> size_t { return isMapped() ? mapped_size : sizeof(dummy); }
+
+private:
+    void map(int fd, size_t size) {
+        if (size > sizeof(MemoryStorage::Header)) {
+            mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            mapped_size = size;
+        }
+        // Mapping stays valid after close
+        close(fd);
+    }
+
+    void* mapped{MAP_FAILED};
+    size_t mapped_size{0};
+    alignas(MemoryStorage::Header) uint8_t dummy[sizeof(MemoryStorage::Header) + 64]{};
+};
+
+template <overflow::Type Overflow = overflow::evict_oldest>
+class MmapRingBuffer : private MmapFile, public BasicRingBuffer<MemoryStorage, Overflow> {
+public:
+    // Create file (or open existing one). If file contains buffer of the
+    // same size, records are recovered, in other case buffer is formatted.
+    // Call before other processes attach.
+    MmapRingBuffer(const char* path, size_t size)
+        : MmapFile(path, size)
+        , BasicRingBuffer<MemoryStorage, Overflow>(memory(), MmapFile::size())
+    {
+        if (this->storage.isValid()) {
+            this->recover();
+        } else {
+            this->storage.format();
+        }
+        valid = isMapped();
+    }
+
+    // Attach to existing buffer, created by another process
+    explicit MmapRingBuffer(const char* path)
+        : MmapFile(path)
+        , BasicRingBuffer<MemoryStorage, Overflow>(memory(), MmapFile::size())
+    {
+        valid = isMapped();
+        if (!valid) { this->storage.format(); }
+    }
+
+    // False if file can't be mapped, or has no valid buffer (on attach).
+    // Buffer is usable in this case, but data goes to small local block.
+    auto isOpen() const -> bool { return valid; }
+
+    auto isShared() const -> bool override { return true; }
+
+    //
+    // Recover from writer process, killed in the middle of write. Such
+    // writer stays counted forever, and published index never moves. Call
+    // periodically (for example, once per second), from one process only.
+    // If buffer has active writers and published index did not change since
+    // the previous call, writers are considered dead, and all reserved data
+    // is published. Record of dead writer can be incomplete (printed as
+    // garbage or broken). Interval must be much longer than any write.
+    // Returns true if buffer was unlocked.
+    //
+    auto unlockStalled() -> bool {
+        auto& ctrl = this->storage.control();
+        size_t writers{ctrl.writers_count.load(etl::memory_order_relaxed)};
+        size_t head{ctrl.head_idx.load(etl::memory_order_relaxed)};
+
+        bool stalled{writers > 0 && writers == stalled_writers && head == stalled_head};
+        stalled_writers = writers;
+        stalled_head = head;
+
+        if (!stalled) { return false; }
+
+        // Fails if live writer is inside now, try on the next call
+        if (!ctrl.writers_count.compare_exchange_strong(writers, 0,
+            etl::memory_order_relaxed, etl::memory_order_relaxed)) { return false; }
+
+        // The same as publish() by the last writer. If a new writer
+        // published meanwhile, its index is newer, keep it.
+        size_t upcoming{ctrl.upcoming_idx.load(etl::memory_order_relaxed)};
+        ctrl.head_idx.compare_exchange_strong(head, upcoming,
+            etl::memory_order_release, etl::memory_order_relaxed);
+
+        stalled_writers = 0;
+        return true;
+    }
+
+private:
+    bool valid{false};
+    size_t stalled_writers{0};
+    size_t stalled_head{0};
+};
+
+} // namespace jetlog
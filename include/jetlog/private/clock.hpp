@@ -0,0 +1,99 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace jetlog {
+
+//
+// Writer clock policies. Clock must define `Type` (uint32_t or uint64_t) and
+// `now()` method, returning monotonic time in any units. It's called on each
+// push, keep it fast. For example:
+//
+//   struct CycleClock {
+//       using Type = uint64_t;
+//       auto now() -> uint64_t { return esp_cpu_get_cycle_count(); }
+//   };
+//
+
+// Default. Time is taken from virtual `Writer::getTime()`, for compatibility.
+struct VirtualClock {
+    using Type = uint32_t;
+};
+
+
+//
+// Restores timestamps on reader side. Writer with `DeltaTime` option writes
+// full time only in the first record of each 64K ticks period, and low 16 bits
+// in the rest. Upper bits are taken from the last full time.
+//
+// Must see records in the same order as written. Fine for ring buffer, but
+// not for ShardedRingBuffer (records of the same writer go to different
+// shards).
+//
+// If records were lost (evicted), call reset(). Full time record of the next
+// period can be lost too, and low bits can't be resolved until the next full
+// time.
+//
+class TimestampDecoder {
+public:
+    // Record without timestamp, or not restorable (no full time seen yet)
+    enum : uint64_t { NoTime = 0xFFFFFFFFFFFFFFFFull };
+
+    template <typename Helpers>
+    auto decode(const RecordData& record, uint32_t offset) -> uint64_t {
+        auto type = Helpers::readHeader(record, offset).typeId;
+        auto value = Helpers::template getAsNum<uint64_t>(record, offset);
+
+        if (type != static_cast<uint8_t>(DataType::U16)) {
+            // 32-bit max is "no time" of default clock
+            if (type == static_cast<uint8_t>(DataType::U32) && value == 0xFFFFFFFF) { return NoTime; }
+
+            last = value;
+            full = value;
+            return last;
+        }
+
+        if (last == NoTime) { return NoTime; }
+
+        // Writer places full time before other records of its period, so
+        // only that period can be resolved, and late records of the previous
+        // one (parallel writers can place records a bit out of order, at
+        // period border). Anything else means full time record was lost.
+        uint64_t current{(full & ~uint64_t{0xFFFF}) | value};
+        bool current_valid{isValid(current)};
+        bool previous_valid{current >= 0x10000 && current - 0x10000 + LateWindow >= full &&
+            isValid(current - 0x10000)};
+
+        if (!current_valid && !previous_valid) { return NoTime; }
+
+        // If both fit, pick the nearest to previous record
+        if (previous_valid && (!current_valid || distanceToLast(current - 0x10000) < distanceToLast(current))) {
+            current -= 0x10000;
+        }
+
+        last = current;
+        return current;
+    }
+
+    void reset() { last = NoTime; }
+
+private:
+    static constexpr uint64_t LateWindow = 0x1000;
+
+    // Time goes back only for late records, and not before full time
+    auto isValid(uint64_t time) const -> bool {
+        return time + LateWindow >= full && time + LateWindow >= last;
+    }
+
+    auto distanceToLast(uint64_t time) const -> uint64_t {
+        return time > last ? time - last : last - time;
+    }
+
+    uint64_t last{NoTime};
+    uint64_t full{0};
+};
+
+} // namespace jetlog
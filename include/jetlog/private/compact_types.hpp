@@ -0,0 +1,581 @@
+#pragma once
+
+#include "types.hpp"
+
+#include <etl/algorithm.h>
+#include <etl/limits.h>
+#include <etl/to_string.h>
+#include <etl/type_traits.h>
+#include <etl/vector.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+//
+// Compact data encoding. Alternative to default one, to reduce record size.
+//
+// - Header is a single byte: type ID in high nibble, data size in low nibble.
+//   If size is >= 15, low nibble is 15 and real size follows as varint.
+// - Integers are stored as varints (LEB128), signed ones are zigzag-encoded.
+// - Floats, doubles and pointers are stored as is, little-endian.
+//
+
+namespace jetlog {
+
+constexpr uint8_t CompactSizeExtended = 15;
+
+class CompactEncoderHelpers {
+public:
+    template<typename T>
+    static constexpr auto dynamicSize(const T&) -> size_t { return 0; }
+
+    static constexpr auto varintSize(uint64_t value) -> size_t {
+        size_t size{1};
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    static constexpr auto headerSize(size_t size) -> size_t {
+        return size < CompactSizeExtended ? 1 : 1 + varintSize(size);
+    }
+
+    template<typename TOUT>
+    static void writeHeader(uint32_t paramTypeID, uint32_t size, TOUT& out) {
+        if (size < CompactSizeExtended) {
+            out.push_back(static_cast<uint8_t>((paramTypeID << 4) | size));
+            return;
+        }
+        out.push_back(static_cast<uint8_t>((paramTypeID << 4) | CompactSizeExtended));
+        writeVarint(size, out);
+    }
+
+    template<typename TOUT>
+    static void writeVarint(uint64_t value, TOUT& out) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Header with varint value. Values below 2^49 (most of them) take up to
+    // 7 bytes, and are written with header in one word.
+    template<typename TOUT>
+    static void writeVarintParam(uint32_t paramTypeID, uint64_t value, TOUT& out) {
+        size_t size{varintSize(value)};
+        uint64_t header{(paramTypeID << 4) | size};
+
+        if (size > 7) {
+            out.push_back(static_cast<uint8_t>(header));
+            writeVarint(value, out);
+            return;
+        }
+
+        uint64_t word{header};
+        for (size_t i{1}; i < size; i++) {
+            word |= static_cast<uint64_t>((value & 0x7F) | 0x80) << (8 * i);
+            value >>= 7;
+        }
+        word |= value << (8 * size);
+
+        writeWord(word, 1 + size, out);
+    }
+
+    // Header with fixed size value (shorter than CompactSizeExtended). See
+    // EncoderHelpers::writeFixed().
+    template<typename V, typename TOUT>
+    static void writeFixed(uint32_t paramTypeID, V value, TOUT& out) {
+        static_assert(sizeof(V) < CompactSizeExtended, "Value too big");
+
+        constexpr size_t InFirst = sizeof(V) < 7 ? sizeof(V) : 7;
+        auto val = static_cast<uint64_t>(value);
+        uint64_t header{(paramTypeID << 4) | sizeof(V)};
+
+        writeWord(header | (val << 8), 1 + InFirst, out);
+        if (sizeof(V) > InFirst) { writeWord(val >> (InFirst * 8), sizeof(V) - InFirst, out); }
+    }
+};
+
+template <typename T, typename BaseType, DataType TypeId, bool IsSigned>
+class CompactEncoderNumeric : public CompactEncoderHelpers {
+public:
+    static constexpr bool matchType = sizeof(T) == sizeof(BaseType)
+        && etl::is_integral<T>::value
+        && !(IsSigned ^ etl::is_signed<T>::value);
+
+    // Header only, data size depends on value
+    static constexpr size_t fixedSize = 1;
+
+    static auto dynamicSize(const T& value) -> size_t {
+        return varintSize(zigzag(value));
+    }
+
+    template <typename TOUT>
+    static void write(const T& value, TOUT& out) {
+        writeVarintParam(static_cast<uint8_t>(TypeId), zigzag(value), out);
+    }
+
+private:
+    using UBaseType = typename etl::make_unsigned<BaseType>::type;
+
+    static auto zigzag(const T& value) -> uint64_t {
+        auto val = static_cast<BaseType>(value);
+
+        if (!IsSigned) { return static_cast<UBaseType>(val); }
+
+        // (val << 1) ^ (val >> (bits - 1)), without UB on signed shift
+        auto uval = static_cast<UBaseType>(val);
+        auto sign = static_cast<UBaseType>((uval >> (sizeof(BaseType) * 8 - 1)) ? ~UBaseType{0} : 0);
+        return static_cast<UBaseType>(static_cast<UBaseType>(uval << 1) ^ sign);
+    }
+};
+
+
+template <typename T>
+using CompactEncoderI8 = CompactEncoderNumeric<T, int8_t, DataType::I8, true>;
+
+template <typename T>
+using CompactEncoderI16 = CompactEncoderNumeric<T, int16_t, DataType::I16, true>;
+
+template <typename T>
+using CompactEncoderI32 = CompactEncoderNumeric<T, int32_t, DataType::I32, true>;
+
+template <typename T>
+using CompactEncoderI64 = CompactEncoderNumeric<T, int64_t, DataType::I64, true>;
+
+template <typename T>
+using CompactEncoderU8 = CompactEncoderNumeric<T, uint8_t, DataType::U8, false>;
+
+template <typename T>
+using CompactEncoderU16 = CompactEncoderNumeric<T, uint16_t, DataType::U16, false>;
+
+template <typename T>
+using CompactEncoderU32 = CompactEncoderNumeric<T, uint32_t, DataType::U32, false>;
+
+template <typename T>
+using CompactEncoderU64 = CompactEncoderNumeric<T, uint64_t, DataType::U64, false>;
+
+template <typename T>
+using CompactEncoderUInt = CompactEncoderNumeric<T, T,
+    sizeof(T) == 2 ? DataType::U16 : sizeof(T) == 4 ? DataType::U32 : DataType::U64, false>;
+
+
+template <typename T>
+class CompactEncoderFlt : public CompactEncoderHelpers {
+public:
+    static constexpr bool matchType = EncoderFlt<T>::matchType;
+
+    static constexpr size_t fixedSize = 1 + sizeof(uint32_t);
+
+    template <typename TOUT>
+    static void write(const T& value, TOUT& out) {
+        uint32_t result{0};
+        memcpy(&result, &value, sizeof(result));
+
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            result = byteswap(result);
+        #endif
+
+        writeFixed(static_cast<uint8_t>(DataType::Flt), result, out);
+    }
+};
+
+template <typename T>
+class CompactEncoderDbl : public CompactEncoderHelpers {
+public:
+    static constexpr bool matchType = EncoderDbl<T>::matchType;
+
+    static constexpr size_t fixedSize = 1 + sizeof(uint64_t);
+
+    template <typename TOUT>
+    static void write(const T& value, TOUT& out) {
+        uint64_t result{0};
+        memcpy(&result, &value, sizeof(result));
+
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            result = byteswap(result);
+        #endif
+
+        writeFixed(static_cast<uint8_t>(DataType::Dbl), result, out);
+    }
+};
+
+template <typename T>
+class CompactEncoderStdString : public CompactEncoderHelpers {
+public:
+    static constexpr bool matchType = EncoderStdString<T>::matchType;
+
+    // Header size depends on string length
+    static constexpr size_t fixedSize = 0;
+
+    static auto dynamicSize(const T& value) -> size_t {
+        return headerSize(value.length()) + value.length();
+    }
+
+    template <typename TOUT>
+    static void write(const T& value, TOUT& out) {
+        writeHeader(static_cast<uint8_t>(DataType::Str), value.length(), out);
+        out.insert(out.end(), value.begin(), value.end());
+    }
+};
+
+template <typename T>
+class CompactEncoderCString : public CompactEncoderHelpers {
+public:
+    static constexpr bool matchType = EncoderCString<T>::matchType;
+
+    static constexpr size_t fixedSize = 0;
+
+    static auto dynamicSize(const char* value) -> size_t {
+        return dynamicSize(SizedCString{value, strlen(value)});
+    }
+
+    static auto dynamicSize(const SizedCString& value) -> size_t {
+        return headerSize(value.length) + value.length;
+    }
+
+    template <typename TOUT>
+    static void write(const char* value, TOUT& out) {
+        write(SizedCString{value, strlen(value)}, out);
+    }
+
+    template <typename TOUT>
+    static void write(const SizedCString& value, TOUT& out) {
+        writeHeader(static_cast<uint8_t>(DataType::Str), value.length, out);
+        out.insert(out.end(), value.str, value.str + value.length);
+    }
+};
+
+// See EncoderStrRef
+class CompactEncoderStrRef : public CompactEncoderHelpers {
+public:
+    static constexpr size_t fixedSize = 1 + sizeof(uintptr_t);
+
+    template <typename TOUT>
+    static void write(const char* value, TOUT& out) {
+        writeFixed(static_cast<uint8_t>(DataType::StrRef), reinterpret_cast<uintptr_t>(value), out);
+    }
+};
+
+template <typename T>
+class CompactEncoderStaticStr : public CompactEncoderHelpers {
+public:
+    static constexpr bool matchType = EncoderStaticStr<T>::matchType;
+
+    static constexpr size_t fixedSize = CompactEncoderStrRef::fixedSize;
+
+    template <typename TOUT>
+    static void write(const static_str& value, TOUT& out) {
+        CompactEncoderStrRef::write(value.str, out);
+    }
+};
+
+
+struct CompactDataHeader {
+    uint16_t size;
+    uint8_t typeId;
+    uint8_t headerSize;
+};
+
+// Base for compact decoders. Static methods are the same as in IDecoder.
+class ICompactDecoder {
+public:
+    // 1 byte + up to 3 bytes of varint size (uint16)
+    enum : size_t { MaxHeaderSize = 4 };
+
+    static auto matchTypeTag(uint8_t) -> bool {
+        assert("This method must be overriden");
+    }
+
+    explicit ICompactDecoder(const RecordData& in, uint32_t recordOffset)
+        : input{in}
+    {
+        auto header = readHeader(in, recordOffset);
+        dataOffset = recordOffset + header.headerSize;
+        dataSize = header.size;
+    }
+
+    static auto isAvailableAt(const RecordData& in, uint32_t recordOffset) -> bool {
+        if (recordOffset >= in.size()) { return false; }
+
+        auto header = readHeader(in, recordOffset);
+        return recordOffset + header.headerSize + header.size <= in.size();
+    }
+
+    template<typename T>
+    static auto getAsNum(const RecordData& in, uint32_t recordOffset) -> T {
+        static_assert(etl::is_integral<T>::value, "Type must be integral");
+
+        if (!isAvailableAt(in, recordOffset)) { return T{0}; }
+
+        auto header = readHeader(in, recordOffset);
+        uint64_t value{readVarint(in, recordOffset + header.headerSize, header.size)};
+
+        // Signed types IDs are even: I8, I16, I32, I64
+        if (header.typeId <= static_cast<uint8_t>(DataType::I64) && (header.typeId & 1) == 0) {
+            return static_cast<T>(unzigzag(value));
+        }
+        return static_cast<T>(value);
+    }
+
+    static auto getAsStringView(const RecordData& in, uint32_t recordOffset) -> etl::string_view {
+        if (!isAvailableAt(in, recordOffset)) { return etl::string_view(); }
+
+        auto header = readHeader(in, recordOffset);
+        uint32_t dataOffset = recordOffset + header.headerSize;
+
+        if (header.typeId == static_cast<uint8_t>(DataType::StrRef)) {
+            if (!in.resolvesRefs()) { return etl::string_view(UnresolvedRef); }
+
+            const auto* str = reinterpret_cast<const char*>(loadLE<uintptr_t>(in.data() + dataOffset, header.size));
+            return str ? etl::string_view(str) : etl::string_view();
+        }
+
+        if (header.size == 0) { return etl::string_view(); }
+
+        return etl::string_view(reinterpret_cast<const char*>(&in[dataOffset]), header.size);
+    }
+
+    static auto getNextOffset(const RecordData& in, uint32_t recordOffset) -> uint32_t {
+        if (recordOffset >= in.size()) { return in.size(); }
+
+        auto header = readHeader(in, recordOffset);
+        return recordOffset + header.headerSize + header.size;
+    }
+
+    // If header is broken (varint out of data), returned size points beyond
+    // the end of data, and will be rejected by isAvailableAt().
+    static auto readHeader(const RecordData& in, uint32_t recordOffset) -> CompactDataHeader {
+        uint8_t first{in[recordOffset]};
+        CompactDataHeader header{
+            static_cast<uint16_t>(first & 0x0F),
+            static_cast<uint8_t>(first >> 4),
+            1
+        };
+
+        if (header.size < CompactSizeExtended) { return header; }
+
+        uint32_t size{0};
+        uint32_t pos{recordOffset + 1};
+        for (uint8_t shift{0}; shift < 21; shift += 7) {
+            if (pos >= in.size()) {
+                return { etl::numeric_limits<uint16_t>::max(), header.typeId, 1 };
+            }
+            uint8_t byte{in[pos++]};
+            size |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if ((byte & 0x80) == 0) { break; }
+        }
+
+        header.size = static_cast<uint16_t>(etl::min<uint32_t>(size, etl::numeric_limits<uint16_t>::max()));
+        header.headerSize = static_cast<uint8_t>(pos - recordOffset);
+        return header;
+    }
+
+    template<typename TOUT>
+    static void writeHeader(uint32_t paramTypeID, uint32_t size, TOUT& out) {
+        CompactEncoderHelpers::writeHeader(paramTypeID, size, out);
+    }
+
+protected:
+    static auto readVarint(const RecordData& in, uint32_t offset, uint32_t size) -> uint64_t {
+        uint64_t value{0};
+        for (uint32_t i{0}; i < size && i < 10; i++) {
+            value |= static_cast<uint64_t>(in[offset + i] & 0x7F) << (7 * i);
+        }
+        return value;
+    }
+
+    static auto unzigzag(uint64_t value) -> int64_t {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    RecordData input;
+    uint32_t dataOffset;
+    uint32_t dataSize;
+};
+
+template <typename T, DataType TypeId>
+class CompactDecoderNumeric : public ICompactDecoder {
+public:
+    explicit CompactDecoderNumeric(const RecordData& in, uint32_t recordOffset)
+        : ICompactDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool {
+        return ttag == static_cast<uint8_t>(TypeId);
+    }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        etl::format_spec spec;
+
+        FormatParser::parse_format(fmt, 0, spec);
+        format(out, spec);
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        etl::to_string(pickValue(), out, spec, true);
+    }
+
+protected:
+    auto pickValue() -> T {
+        uint64_t value{readVarint(input, dataOffset, dataSize)};
+        return etl::is_signed<T>::value
+            ? static_cast<T>(unzigzag(value))
+            : static_cast<T>(value);
+    }
+};
+
+
+using CompactDecoderI8 = CompactDecoderNumeric<int8_t, DataType::I8>;
+
+using CompactDecoderI16 = CompactDecoderNumeric<int16_t, DataType::I16>;
+
+using CompactDecoderI32 = CompactDecoderNumeric<int32_t, DataType::I32>;
+
+using CompactDecoderI64 = CompactDecoderNumeric<int64_t, DataType::I64>;
+
+using CompactDecoderU8 = CompactDecoderNumeric<uint8_t, DataType::U8>;
+
+using CompactDecoderU16 = CompactDecoderNumeric<uint16_t, DataType::U16>;
+
+using CompactDecoderU32 = CompactDecoderNumeric<uint32_t, DataType::U32>;
+
+using CompactDecoderU64 = CompactDecoderNumeric<uint64_t, DataType::U64>;
+
+class CompactDecoderFlt : public ICompactDecoder {
+public:
+    explicit CompactDecoderFlt(const RecordData& in, uint32_t recordOffset)
+        : ICompactDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool {
+        return ttag == static_cast<uint8_t>(DataType::Flt);
+    }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        (void)fmt;
+        // force std::to_string() like behaviour - 6 digits fractional part.
+        etl::to_string(pickValue(), out, etl::format_spec().precision(6), true);
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+
+protected:
+    auto pickValue() -> float {
+        auto val = loadLE<uint32_t>(input.data() + dataOffset, dataSize);
+
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            val = byteswap(val);
+        #endif
+
+        float result;
+        memcpy(&result, &val, sizeof(result));
+        return result;
+    }
+};
+
+class CompactDecoderDbl : public ICompactDecoder {
+public:
+    explicit CompactDecoderDbl(const RecordData& in, uint32_t recordOffset)
+        : ICompactDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool {
+        return ttag == static_cast<uint8_t>(DataType::Dbl);
+    }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        (void)fmt;
+        // force std::to_string() like behaviour - 6 digits fractional part.
+        etl::to_string(pickValue(), out, etl::format_spec().precision(6), true);
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+
+protected:
+    auto pickValue() -> double {
+        auto val = loadLE<uint64_t>(input.data() + dataOffset, dataSize);
+
+        #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            val = byteswap(val);
+        #endif
+
+        double result{0};
+        memcpy(&result, &val, sizeof(result));
+        return result;
+    }
+};
+
+class CompactDecoderStr : public ICompactDecoder {
+public:
+    explicit CompactDecoderStr(const RecordData& in, uint32_t recordOffset)
+        : ICompactDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool {
+        return ttag == static_cast<uint8_t>(DataType::Str);
+    }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        (void)fmt;
+        out.append(reinterpret_cast<const char*>(&input[dataOffset]), dataSize);
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+};
+
+// See DecoderStrRef
+class CompactDecoderStrRef : public ICompactDecoder {
+public:
+    explicit CompactDecoderStrRef(const RecordData& in, uint32_t recordOffset)
+        : ICompactDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool {
+        return ttag == static_cast<uint8_t>(DataType::StrRef);
+    }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        (void)fmt;
+        if (!input.resolvesRefs()) {
+            out.append(UnresolvedRef);
+            return;
+        }
+
+        const auto* str = reinterpret_cast<const char*>(loadLE<uintptr_t>(input.data() + dataOffset, dataSize));
+        if (str) { out.append(str); }
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+};
+
+class CompactDecoderUnknown : public ICompactDecoder {
+public:
+    explicit CompactDecoderUnknown(const RecordData& in, uint32_t recordOffset)
+        : ICompactDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool { (void)ttag; return false; }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        (void)fmt;
+        out.append("[UNKNOWN]");
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+};
+
+} // namespace jetlog
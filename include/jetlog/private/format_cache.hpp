@@ -0,0 +1,143 @@
+#pragma once
+
+#include "format_parser.hpp"
+#include "string_tokenizer.hpp"
+
+#include <etl/algorithm.h>
+#include <etl/array.h>
+#include <etl/format_spec.h>
+#include <etl/limits.h>
+#include <etl/string_view.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace jetlog {
+
+// Part of format string, literal text or placeholder
+struct FormatSegment {
+    uint16_t offset;
+    uint16_t length;
+    bool is_placeholder;
+    etl::format_spec spec;
+};
+
+// Format string, split to segments
+template <size_t MaxSegments>
+struct FormatTemplate {
+    size_t segments_count;
+    etl::array<FormatSegment, MaxSegments> segments;
+};
+
+//
+// Cache of pre-parsed format strings for reader. Each entry keeps format
+// string split to segments (offsets in source string) with parsed specs for
+// placeholders. So formatting of repeated message does not need to tokenize
+// and parse format again.
+//
+// Fixed memory, direct-mapped by FNV-1a hash. Entry keeps a copy of format
+// string, to confirm the match (hashes of different strings can collide).
+// Strings longer than `MaxLength` are not cached.
+//
+template <size_t Entries, size_t MaxSegments = 16, size_t MaxLength = 128>
+class FormatCache {
+public:
+    static_assert(Entries > 0, "Use NoFormatCache to disable cache");
+    static_assert(MaxLength <= etl::numeric_limits<uint16_t>::max(), "Segment offsets are 16-bit");
+
+    struct Entry : FormatTemplate<MaxSegments> {
+        uint32_t hash;
+        size_t length;
+        etl::array<char, MaxLength> text;
+    };
+
+    // Returns pre-parsed template, or nullptr if it can not be cached (too
+    // many segments or too long).
+    auto get(etl::string_view fmt) -> const Entry* {
+        if (fmt.length() > MaxLength) { return nullptr; }
+
+        uint32_t hash{fnv1a(fmt)};
+        Entry& entry{entries[hash % Entries]};
+
+        if (entry.segments_count > 0 && entry.hash == hash && entry.length == fmt.length() &&
+            etl::equal(fmt.begin(), fmt.end(), entry.text.begin())) {
+            return &entry;
+        }
+
+        if (!parse(fmt, entry)) {
+            entry.segments_count = 0;
+            return nullptr;
+        }
+
+        entry.hash = hash;
+        entry.length = fmt.length();
+        etl::copy_n(fmt.data(), fmt.length(), entry.text.data());
+
+        fill_count++;
+        last_filled = &entry;
+        return &entry;
+    }
+
+    // Number of entries filled so far
+    auto fills() const -> uint32_t { return fill_count; }
+
+    // Drop entry, filled after fills() returned `count`, if its source turned
+    // out to be overwritten while parsing. Only the last one is tracked.
+    void rollback(uint32_t count) {
+        if (count == fill_count || last_filled == nullptr) { return; }
+
+        last_filled->segments_count = 0;
+        last_filled = nullptr;
+    }
+
+    static auto fnv1a(etl::string_view str) -> uint32_t {
+        uint32_t hash{2166136261U};
+        for (char c : str) {
+            hash ^= static_cast<uint8_t>(c);
+            hash *= 16777619U;
+        }
+        return hash;
+    }
+
+private:
+    static auto parse(etl::string_view fmt, Entry& entry) -> bool {
+        size_t count{0};
+
+        for (const auto& token : StringTokenizer(fmt)) {
+            if (count >= MaxSegments) { return false; }
+
+            FormatSegment& segment{entry.segments[count++]};
+            segment.offset = static_cast<uint16_t>(token.text.data() - fmt.data());
+            segment.length = static_cast<uint16_t>(token.text.length());
+            segment.is_placeholder = token.is_placeholder;
+            segment.spec = etl::format_spec{};
+
+            if (token.is_placeholder) {
+                FormatParser::parse_format(token.text, 0, segment.spec);
+            }
+        }
+
+        // Empty format string also needs valid (non-empty) entry
+        if (count == 0) {
+            if (MaxSegments == 0) { return false; }
+            entry.segments[count++] = { 0, 0, false, etl::format_spec{} };
+        }
+
+        entry.segments_count = count;
+        return true;
+    }
+
+    etl::array<Entry, Entries> entries{};
+    uint32_t fill_count{0};
+    Entry* last_filled{nullptr};
+};
+
+// Stub to disable cache (default)
+class NoFormatCache {
+public:
+    auto get(etl::string_view) -> const FormatTemplate<1>* { return nullptr; }
+    auto fills() const -> uint32_t { return 0; }
+    void rollback(uint32_t) {}
+};
+
+} // namespace jetlog
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "ring_buffer.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace jetlog {
+
+//
+// Storage in external memory region. Control block (with indices) is placed
+// at the beginning, data after it. Memory must be aligned as
+// MemoryStorage::Header.
+//
+// Control block is protected with magic and CRC of static fields. Indices
+// are not covered (those change on every write), and are validated by
+// ring buffer recover() instead.
+//
+class MemoryStorage {
+public:
+    struct Header {
+        uint32_t magic;
+        uint32_t capacity;
+        uint32_t crc;
+        RingBufferControl control;
+    };
+
+    enum : uint32_t { Magic = 0x474F4C4A }; // "JLOG"
+
+    using Control = RingBufferControl;
+
+    // Indices are stored in [0, capacity), to validate on restore
+    static constexpr bool FreeRunningIndices = false;
+
+    MemoryStorage(void* memory, size_t size)
+        : header{static_cast<Header*>(memory)}
+        , buffer{static_cast<uint8_t*>(memory) + sizeof(Header)}
+        , buffer_size{size > sizeof(Header) ? size - sizeof(Header) : 0}
+    {}
+
+    auto capacity() const -> size_t { return buffer_size; }
+
+    auto data() -> uint8_t* { return buffer; }
+    auto data() const -> const uint8_t* { return buffer; }
+
+    auto control() -> RingBufferControl& { return header->control; }
+    auto control() const -> const RingBufferControl& { return header->control; }
+
+    // Check if memory contains control block of buffer with the same size
+    auto isValid() const -> bool {
+        return header->magic == Magic &&
+            header->capacity == buffer_size &&
+            header->crc == checksum(header->magic, header->capacity);
+    }
+
+    // Initialize empty buffer
+    void format() {
+        header->control.head_idx = 0;
+        header->control.upcoming_idx = 0;
+        header->control.tail_idx = 0;
+        header->control.writers_count = 0;
+        header->control.sequence = 0;
+
+        header->magic = Magic;
+        header->capacity = static_cast<uint32_t>(buffer_size);
+        header->crc = checksum(header->magic, header->capacity);
+    }
+
+private:
+    // CRC-32 (IEEE), bitwise. Called on init only, speed does not matter.
+    static auto checksum(uint32_t magic, uint32_t capacity) -> uint32_t {
+        uint32_t crc{0xFFFFFFFF};
+        uint32_t values[] = { magic, capacity };
+
+        for (uint32_t value : values) {
+            for (size_t i{0}; i < sizeof(value); i++) {
+                crc ^= (value >> (i * 8)) & 0xFF;
+                for (int bit{0}; bit < 8; bit++) {
+                    crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320 : crc >> 1;
+                }
+            }
+        }
+        return ~crc;
+    }
+
+    Header* header;
+    uint8_t* buffer;
+    size_t buffer_size;
+};
+
+//
+// Ring buffer in memory, which survives restart (for example, no-init or RTC
+// RAM on MCU). Records, written before watchdog reset or crash, are
+// available for reading after restart:
+//
+//   alignas(8) static RTC_NOINIT_ATTR uint8_t logMemory[4096];
+//   jetlog::PersistentRingBuffer<> ringBuffer(logMemory, sizeof(logMemory));
+//
+// If memory has no valid control block (cold start), buffer is initialized
+// as empty.
+//
+template <overflow::Type Overflow = overflow::evict_oldest>
+class PersistentRingBuffer : public BasicRingBuffer<MemoryStorage, Overflow> {
+public:
+    PersistentRingBuffer(void* memory, size_t size)
+        : BasicRingBuffer<MemoryStorage, Overflow>(memory, size)
+    {
+        if (this->storage.isValid()) {
+            recovered = this->recover();
+        } else {
+            this->storage.format();
+        }
+    }
+
+    // Number of records, restored after restart
+    auto recoveredRecords() const -> size_t { return recovered; }
+
+private:
+    size_t recovered{0};
+};
+
+} // namespace jetlog
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "ring_buffer.hpp"
+#include "types.hpp"
+
+#include <etl/algorithm.h>
+#include <etl/vector.h>
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace jetlog {
+
+//
+// Framing for binary export of raw records, to decode on host side:
+//
+//   [0xA5] [0x5A] [size: uint16 LE] [record data] [CRC-8 of size + data]
+//
+struct RawFrame {
+    enum : uint8_t { Sync1 = 0xA5, Sync2 = 0x5A };
+    enum : size_t { Overhead = 5 };
+
+    // CRC-8, polynomial 0x07
+    static auto crc8(uint8_t crc, uint8_t byte) -> uint8_t {
+        crc ^= byte;
+        for (int i{0}; i < 8; i++) {
+            crc = (crc & 0x80) ? static_cast<uint8_t>((crc << 1) ^ 0x07) : static_cast<uint8_t>(crc << 1);
+        }
+        return crc;
+    }
+};
+
+//
+// Reads records from ring buffer and writes them as frames, without
+// formatting. Interned strings (pointers) are replaced with text, because
+// those can be resolved only on device ("<ref>" for shared buffers, see
+// IRingBuffer::isShared()). Strings are truncated if needed, to keep record
+// size within MaxRecordSize.
+//
+// Format - decoder helpers of used data format (IDecoder or ICompactDecoder).
+//
+template <size_t MaxRecordSize = 256, typename Format = IDecoder>
+class RawReader {
+public:
+    static constexpr size_t MaxFrameSize = MaxRecordSize + RawFrame::Overhead;
+
+    explicit RawReader(jetlog::IRingBuffer& buf) : ringBuffer{buf}, resolveRefs{!buf.isShared()} {}
+
+    // Append single frame to output. Returns false if no data, or if output
+    // has no space for MaxFrameSize (nothing is read in this case).
+    auto pull(etl::ivector<uint8_t>& output) -> bool {
+        if (output.available() < MaxFrameSize) { return false; }
+
+        etl::vector<uint8_t, MaxRecordSize> record;
+        if (!ringBuffer.readRecord(record)) { return false; }
+
+        // First pass - calculate space, available for interned strings text
+        size_t fixed_size{0};
+        uint32_t offset{0};
+
+        while (Format::isAvailableAt(record, offset)) {
+            fixed_size += isStrRef(record, offset)
+                ? static_cast<size_t>(Format::MaxHeaderSize)
+                : Format::getNextOffset(record, offset) - offset;
+            offset = Format::getNextOffset(record, offset);
+        }
+        // Broken tail (if any) is copied as is
+        fixed_size += record.size() - offset;
+
+        size_t text_budget{MaxRecordSize > fixed_size ? MaxRecordSize - fixed_size : 0};
+
+        // Second pass - write frame. CRC is calculated at the end, over
+        // written size and data.
+        output.push_back(RawFrame::Sync1);
+        output.push_back(RawFrame::Sync2);
+        size_t size_pos{output.size()};
+        output.push_back(0);
+        output.push_back(0);
+
+        size_t payload_start{output.size()};
+        offset = 0;
+
+        while (Format::isAvailableAt(record, offset)) {
+            uint32_t next{Format::getNextOffset(record, offset)};
+
+            if (isStrRef(record, offset)) {
+                auto text = Format::getAsStringView(RecordData{record, resolveRefs}, offset);
+                size_t length{etl::min(text.length(), text_budget)};
+                text_budget -= length;
+
+                Format::writeHeader(static_cast<uint8_t>(DataType::Str), length, output);
+                for (size_t i{0}; i < length; i++) { output.push_back(static_cast<uint8_t>(text[i])); }
+            } else {
+                for (uint32_t i{offset}; i < next; i++) { output.push_back(record[i]); }
+            }
+            offset = next;
+        }
+        for (uint32_t i{offset}; i < record.size(); i++) { output.push_back(record[i]); }
+
+        size_t payload_size{output.size() - payload_start};
+        output[size_pos] = static_cast<uint8_t>(payload_size);
+        output[size_pos + 1] = static_cast<uint8_t>(payload_size >> 8);
+
+        uint8_t crc{0};
+        for (size_t i{size_pos}; i < output.size(); i++) { crc = RawFrame::crc8(crc, output[i]); }
+        output.push_back(crc);
+
+        return true;
+    }
+
+private:
+    static auto isStrRef(const etl::ivector<uint8_t>& record, uint32_t offset) -> bool {
+        return Format::readHeader(record, offset).typeId == static_cast<uint8_t>(DataType::StrRef);
+    }
+
+    jetlog::IRingBuffer& ringBuffer;
+    bool resolveRefs;
+};
+
+//
+// Host side. Extracts records from byte stream with frames. Garbage between
+// frames and broken frames are skipped.
+//
+template <size_t MaxRecordSize = 256>
+class RawFrameDecoder {
+public:
+    // Returns true when complete valid record is available via record()
+    auto feed(uint8_t byte) -> bool {
+        switch (state) {
+            case State::Sync1:
+                if (byte == RawFrame::Sync1) { state = State::Sync2; }
+                return false;
+
+            case State::Sync2:
+                if (byte == RawFrame::Sync2) {
+                    state = State::Size1;
+                } else if (byte != RawFrame::Sync1) {
+                    state = State::Sync1;
+                }
+                return false;
+
+            case State::Size1:
+                size = byte;
+                crc = RawFrame::crc8(0, byte);
+                state = State::Size2;
+                return false;
+
+            case State::Size2:
+                size |= static_cast<uint16_t>(byte << 8);
+                crc = RawFrame::crc8(crc, byte);
+                data.clear();
+
+                if (size > MaxRecordSize) {
+                    errors_count++;
+                    state = State::Sync1;
+                } else {
+                    state = size > 0 ? State::Data : State::Crc;
+                }
+                return false;
+
+            case State::Data:
+                data.push_back(byte);
+                crc = RawFrame::crc8(crc, byte);
+                if (data.size() >= size) { state = State::Crc; }
+                return false;
+
+            case State::Crc:
+                state = State::Sync1;
+                if (byte != crc) {
+                    errors_count++;
+                    return false;
+                }
+                return true;
+        }
+        return false;
+    }
+
+    auto record() const -> const etl::ivector<uint8_t>& { return data; }
+
+    // Number of broken frames
+    auto errors() const -> size_t { return errors_count; }
+
+private:
+    enum class State { Sync1, Sync2, Size1, Size2, Data, Crc };
+
+    State state{State::Sync1};
+    uint16_t size{0};
+    uint8_t crc{0};
+    size_t errors_count{0};
+    etl::vector<uint8_t, MaxRecordSize> data;
+};
+
+} // namespace jetlog
@@ -1,181 +1,832 @@
 #pragma once
 
+#include "waiter.hpp"
+
 #include <etl/algorithm.h>
 #include <etl/array.h>
 #include <etl/atomic.h>
+#include <etl/iterator.h>
 #include <etl/limits.h>
+#include <etl/type_traits.h>
+#include <etl/utility.h>
 #include <etl/vector.h>
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 namespace jetlog {
 
+// Writable memory of reserved record. If record wraps around buffer end, it
+// consists of two parts.
+struct RecordSpan {
+    uint8_t* first{nullptr};
+    size_t first_size{0};
+    uint8_t* second{nullptr};
+    size_t second_size{0};
+
+    auto size() const -> size_t { return first_size + second_size; }
+};
+
+// Read-only record data in buffer memory, for zero-copy read. If record wraps
+// around buffer end, it consists of two parts.
+struct RecordView {
+    const uint8_t* first{nullptr};
+    size_t first_size{0};
+    const uint8_t* second{nullptr};
+    size_t second_size{0};
+    size_t index{0}; // Record position, used by buffer
+    bool follows_gap{false}; // Records before this one were evicted, since previous read
+
+    auto size() const -> size_t { return first_size + second_size; }
+};
+
+// Output adapter for encoders, to write data directly into reserved record.
+// Supports only subset of container methods, used by encoders (append only).
+class RecordWriter {
+public:
+    explicit RecordWriter(const RecordSpan& s) : span{s} {}
+
+    void push_back(uint8_t value) {
+        if (position >= span.size()) {
+            truncated = true;
+            return;
+        }
+        *pointerAt(position++) = value;
+    }
+
+    template <typename TIterator>
+    void insert(size_t /*pos*/, TIterator first, TIterator last) {
+        auto size = static_cast<size_t>(etl::distance(first, last));
+
+        // Fast path, usually data fits in the first segment
+        if (position + size <= span.first_size) {
+            copyTo(span.first + position, first, size);
+            position += size;
+            return;
+        }
+
+        if (position + size > span.size()) {
+            truncated = true;
+            return;
+        }
+
+        if (position < span.first_size) {
+            size_t chunk{etl::min(size, span.first_size - position)};
+            copyTo(span.first + position, first, chunk);
+            etl::advance(first, chunk);
+            position += chunk;
+            size -= chunk;
+        }
+
+        if (size > 0) {
+            copyTo(span.second + (position - span.first_size), first, size);
+            position += size;
+        }
+    }
+
+    auto end() const -> size_t { return position; }
+    auto size() const -> size_t { return position; }
+    auto is_truncated() const -> bool { return truncated; }
+
+private:
+    template <typename TIterator>
+    static void copyTo(uint8_t* dst, TIterator src, size_t size) { etl::copy_n(src, size, dst); }
+
+    // Encoded params are copied from local arrays with constant size, and
+    // memcpy is compiled to a few stores
+    template <typename T>
+    static void copyTo(uint8_t* dst, T* src, size_t size) { memcpy(dst, src, size); }
+
+    auto pointerAt(size_t pos) const -> uint8_t* {
+        return pos < span.first_size
+            ? span.first + pos
+            : span.second + (pos - span.first_size);
+    }
+
+    RecordSpan span;
+    size_t position{0};
+    bool truncated{false};
+};
+
+// Buffer counters, since start or last resetStats(). Collected with relaxed
+// atomics, so values can be slightly inconsistent with each other.
+struct RingBufferStats {
+    size_t records_written{0};
+    size_t bytes_written{0};        // Including record headers
+    size_t records_evicted{0};      // Old records, removed to free space
+    size_t allocation_failures{0};  // Too big records, or no space to evict
+    size_t cas_retries{0};          // Writers collisions in allocation loop
+    size_t high_water_mark{0};      // Max used bytes
+};
+
+// Callback for batch read. Return false to stop reading.
+class IRecordConsumer {
+public:
+    virtual auto consume(const etl::ivector<uint8_t>& data) -> bool = 0;
+
+    // Called before the next record, if records were evicted since previous
+    // read (not read by anyone)
+    virtual void onGap() {}
+};
+
 class IRingBuffer {
 public:
     virtual auto writeRecord(const etl::ivector<uint8_t>& data) -> bool = 0;
     virtual auto writeRecord(const uint8_t* data, size_t size) -> bool = 0;
     virtual auto readRecord(etl::ivector<uint8_t>& data) -> bool = 0;
     virtual auto reset(bool unlock_only = false) -> void = 0;
+
+    // Zero-copy write. Reserve space for record data, fill it in place, and
+    // then publish with commitRecord(). Nothing to commit if reserve failed.
+    //
+    // `important` records are protected from eviction by overflow::keep_errors
+    // policy. Max record size is 16K.
+    virtual auto reserveRecord(size_t size, RecordSpan& span, bool important = false) -> bool = 0;
+    virtual auto commitRecord(const RecordSpan& span) -> void = 0;
+
+    // Next record number, for writers with `Sequence` option. Counter is
+    // kept per buffer, so all writers of one buffer number records together.
+    virtual auto nextSequence() -> uint32_t = 0;
+
+    // Batch read. Pass records to consumer one by one (using `data` as
+    // temporary storage), and remove all of them at the end. Returns number
+    // of records consumed, 0 only if buffer is empty.
+    virtual auto readRecords(etl::ivector<uint8_t>& data, IRecordConsumer& consumer,
+        size_t max_records = etl::numeric_limits<size_t>::max()) -> size_t = 0;
+
+    // Zero-copy read. View the oldest record in place, and remove it with
+    // consumeRecord() after processing. If buffer overflows meanwhile, writers
+    // can evict and overwrite the record. Then consumeRecord() returns false,
+    // and results of processing must be dropped. Don't follow pointers from
+    // data before consumeRecord() confirmed it.
+    virtual auto viewRecord(RecordView& view) -> bool = 0;
+    virtual auto consumeRecord(const RecordView& view) -> bool = 0;
+
+    virtual auto getStats() const -> RingBufferStats = 0;
+    virtual auto resetStats() -> void = 0;
+
+    // Notify reader when used space grows over `watermark` bytes (by default
+    // - when data appears in empty buffer). Set on init, before writes. To
+    // not miss wakeups, reader should wait only after read returned nothing.
+    virtual auto setWaiter(IWaiter* waiter, size_t watermark = 1) -> void = 0;
+
+    // True if writers can be in other processes (shared memory). Pointers
+    // from such records (static_str, InternStrings) are not valid for reader,
+    // and are not followed.
+    virtual auto isShared() const -> bool { return false; }
+};
+
+// What to do when buffer is full
+namespace overflow {
+    enum Type : uint8_t {
+        // Remove old records to free space (default)
+        evict_oldest,
+        // Reject new records, keep old ones. Cheaper, no eviction loop.
+        drop_newest,
+        // Evict old records, but stop at important ones (errors), and
+        // reject new records in this case. Important records stay until
+        // read.
+        keep_errors
+    };
+} // namespace overflow
+
+// Buffer indices
+struct RingBufferControl {
+    etl::atomic<size_t> head_idx{0};       // Index visible to readers (published data)
+    etl::atomic<size_t> upcoming_idx{0};   // Index for next allocation (pre-allocated data)
+    etl::atomic<size_t> tail_idx{0};       // Index where reading starts from
+    etl::atomic<size_t> writers_count{0};  // Number of active writers
+    etl::atomic<uint32_t> sequence{0};     // Next record number
+};
+
+// The same indices, in separate cache lines. Writers allocate via
+// upcoming_idx, reader moves tail_idx, and head_idx is passed from writers
+// to reader. On multicore hosts that avoids false sharing between sides.
+template <size_t CacheLine>
+struct alignas(CacheLine) AlignedRingBufferControl {
+    etl::atomic<size_t> upcoming_idx{0};
+    etl::atomic<size_t> writers_count{0};
+    etl::atomic<uint32_t> sequence{0};
+    alignas(CacheLine) etl::atomic<size_t> head_idx{0};
+    alignas(CacheLine) etl::atomic<size_t> tail_idx{0};
+};
+
+//
+// Default storage, data and indices are in the buffer object.
+//
+// CacheLine - if not 0, indices are placed to separate cache lines (see
+// AlignedRingBufferControl). Costs ~3 cache lines of RAM, useless on single
+// core MCUs.
+//
+template <size_t BufferSize, size_t CacheLine = 0>
+class ArrayStorage {
+public:
+    using Control = typename etl::conditional<CacheLine == 0,
+        RingBufferControl,
+        AlignedRingBufferControl<CacheLine>
+    >::type;
+
+    // Indices are wrapped by mask, see BasicRingBuffer
+    static constexpr bool FreeRunningIndices = (BufferSize & (BufferSize - 1)) == 0;
+
+    static constexpr auto capacity() -> size_t { return BufferSize; }
+
+    auto data() -> uint8_t* { return buffer.data(); }
+    auto data() const -> const uint8_t* { return buffer.data(); }
+
+    auto control() -> Control& { return ctrl; }
+    auto control() const -> const Control& { return ctrl; }
+
+private:
+    // Control goes first. When aligned, data starts at the next cache line.
+    Control ctrl{};
+    etl::array<uint8_t, BufferSize> buffer{};
 };
 
-template <size_t BufferSize>
-class RingBuffer : public IRingBuffer {
+//
+// Ring buffer algorithm over memory, provided by Storage (data array and
+// indices). Use `RingBuffer` alias for regular buffer in object memory.
+//
+// Contiguous - each record is placed in one piece. If record does not fit
+// before buffer end, the rest of buffer is skipped with padding. Costs some
+// space, but allows to access records in place. Records bigger than half of
+// buffer can fail to allocate, depending on position.
+//
+template <typename Storage, overflow::Type Overflow = overflow::evict_oldest, bool Contiguous = false>
+class BasicRingBuffer : public IRingBuffer {
 public:
+    BasicRingBuffer() = default;
+
+    // Pass params to storage constructor
+    template <typename Arg, typename... Args>
+    explicit BasicRingBuffer(Arg&& arg, Args&&... args)
+        : storage{etl::forward<Arg>(arg), etl::forward<Args>(args)...} {}
+
+    // Record size, and flags in the highest bits. Padding is a skipped space
+    // at buffer end (contiguous mode only).
     struct RecordHeader {
-        uint16_t size;
+        enum : uint16_t { SizeMask = 0x3FFF, PaddingFlag = 0x4000, ImportantFlag = 0x8000 };
+
+        uint16_t value;
+
+        auto size() const -> size_t { return value & SizeMask; }
+        auto is_important() const -> bool { return (value & ImportantFlag) != 0; }
+        auto is_padding() const -> bool { return (value & PaddingFlag) != 0; }
     };
 
-    auto writeRecord(const etl::ivector<uint8_t>& data) -> bool override {
+    auto writeRecord(const etl::ivector<uint8_t>& data) -> bool final {
         return writeRecord(data.data(), data.size());
     }
 
-    auto writeRecord(const uint8_t* data, size_t size) -> bool override {
+    auto writeRecord(const uint8_t* data, size_t size) -> bool final {
+        RecordSpan span{};
+        if (!reserveRecord(size, span)) { return false; }
+
+        etl::copy_n(data, span.first_size, span.first);
+        etl::copy_n(data + span.first_size, span.second_size, span.second);
+
+        commitRecord(span);
+        return true;
+    }
+
+    auto reserveRecord(size_t size, RecordSpan& span, bool important = false) -> bool final {
         size_t record_size{sizeof(RecordHeader) + size};
 
-        writers_count.fetch_add(1, etl::memory_order_relaxed);
+        control().writers_count.fetch_add(1, etl::memory_order_relaxed);
 
-        auto allocation_index = allocateSpace(record_size);
-        bool allocation_success = (allocation_index != ALLOCATION_FAILED);
+        size_t allocation_index{0};
 
-        if (allocation_success) {
-            setRecordHeader(allocation_index, { static_cast<uint16_t>(size) });
-            writeBuffer((allocation_index + sizeof(RecordHeader)) % BufferSize, data, size);
+        if (!allocateSpace(record_size, allocation_index)) {
+            allocation_failures.fetch_add(1, etl::memory_order_relaxed);
+            // Still need to release lock and publish records of other writers
+            publish();
+            return false;
         }
 
-        // Independent on write success, try to update head_idx if no more
-        // writers are locking buffer.
+        records_written.fetch_add(1, etl::memory_order_relaxed);
+        bytes_written.fetch_add(record_size, etl::memory_order_relaxed);
 
-        auto current_head = head_idx.load(etl::memory_order_relaxed);
-        auto current_upcoming = upcoming_idx.load(etl::memory_order_relaxed);
-        auto current_writers_count = writers_count.fetch_sub(1, etl::memory_order_relaxed);
+        setRecordHeader(allocation_index, {
+            static_cast<uint16_t>(size | (important ? RecordHeader::ImportantFlag : 0))
+        });
+        span = getSpan(advance(allocation_index, sizeof(RecordHeader)), size);
+        return true;
+    }
 
-        if (current_writers_count == 1) {
-            if (current_head != current_upcoming) {
-                // If update fails => another writer already did update
-                //
-                // In theory, current_upcoming can become outdated here, but
-                // that will be fixed on next write.
-                head_idx.compare_exchange_strong(current_head, current_upcoming,
-                    etl::memory_order_release, etl::memory_order_relaxed);
-            }
-        }
+    auto commitRecord(const RecordSpan& /*span*/) -> void final {
+        publish();
+    }
 
-        return allocation_success;
+    auto nextSequence() -> uint32_t final {
+        return control().sequence.fetch_add(1, etl::memory_order_relaxed);
     }
 
     auto readRecord(etl::ivector<uint8_t>& data) -> bool override {
         while (true) {
-            size_t tail{tail_idx.load(etl::memory_order_relaxed)};
+            size_t tail{control().tail_idx.load(etl::memory_order_relaxed)};
             // Here we use ACQUIRE to sync with writer thread (it updates
             // head_idx on publish).
-            size_t head{head_idx.load(etl::memory_order_acquire)};
+            size_t head{control().head_idx.load(etl::memory_order_acquire)};
 
             if (tail == head) {
+                if (isUpdatedAfterEmpty(head)) { continue; }
+
                 data.clear();
                 return false;
             }
 
             RecordHeader header{};
-            getRecordHeader(tail, header);
-            size_t size{header.size};
+            size_t next_tail{advance(tail, readRecordHeader(tail, header))};
 
-            if (tail_idx.load(etl::memory_order_relaxed) != tail) {
+            if (control().tail_idx.load(etl::memory_order_relaxed) != tail) {
                 // If tail changed - header is invalid, need to retry.
                 continue;
             }
 
-            data.resize(size);
-            size_t next_tail{(tail + sizeof(RecordHeader) + size) % BufferSize};
+            if (header.is_padding()) {
+                // Nothing to read, skip and take the next record
+                skipPadding(tail, next_tail);
+                continue;
+            }
 
-            readBuffer((tail + sizeof(RecordHeader)) % BufferSize, data.data(), size);
+            data.resize(header.size());
+            readBuffer(advance(tail, sizeof(RecordHeader)), data.data(), header.size());
 
-            if (tail_idx.compare_exchange_strong(tail, next_tail,
+            if (control().tail_idx.compare_exchange_strong(tail, next_tail,
                 // Here we use relaxed write, because reader has NO other write
                 // operations to push. And atomics themselves are always ordered.
                 etl::memory_order_relaxed, etl::memory_order_relaxed)) {
+                setReadEnd(next_tail);
                 return true;
             }
         }
     }
 
+    auto readRecords(etl::ivector<uint8_t>& data, IRecordConsumer& consumer,
+        size_t max_records = etl::numeric_limits<size_t>::max()) -> size_t override
+    {
+        size_t start{0};
+        size_t pos{0};
+        size_t count{0};
+        bool evicted{true};
+
+        // If writers evicted records before the first one was consumed,
+        // restart from the new tail. Don't return 0 while data is there.
+        while (evicted && count == 0) {
+            evicted = false;
+            start = control().tail_idx.load(etl::memory_order_relaxed);
+            // Snapshot published data once for the whole batch
+            size_t head{control().head_idx.load(etl::memory_order_acquire)};
+
+            if (start == head && isUpdatedAfterEmpty(head)) {
+                head = control().head_idx.load(etl::memory_order_acquire);
+            }
+
+            pos = start;
+            bool gap{isGapBefore(start)};
+
+            while (pos != head && count < max_records) {
+                RecordHeader header{};
+                size_t next{advance(pos, readRecordHeader(pos, header))};
+
+                // If tail changed - writer evicted records, and data after
+                // `start` can be invalid. Stop here.
+                if (control().tail_idx.load(etl::memory_order_relaxed) != start) {
+                    evicted = true;
+                    break;
+                }
+
+                if (header.is_padding()) {
+                    pos = next;
+                    continue;
+                }
+
+                data.resize(header.size());
+                readBuffer(advance(pos, sizeof(RecordHeader)), data.data(), header.size());
+
+                // Re-check, data could be overwritten while copying
+                if (control().tail_idx.load(etl::memory_order_relaxed) != start) {
+                    evicted = true;
+                    break;
+                }
+
+                pos = next;
+                count++;
+
+                if (gap) {
+                    consumer.onGap();
+                    gap = false;
+                }
+                if (!consumer.consume(data)) { break; }
+            }
+        }
+
+        // Remove all consumed records at once
+        size_t tail{start};
+        while (pos != start && !control().tail_idx.compare_exchange_strong(tail, pos,
+            etl::memory_order_relaxed, etl::memory_order_relaxed))
+        {
+            // Writers evicted some records. If tail is already beyond our
+            // position - nothing to do. In other case retry with new tail.
+            if (distance(start, tail) >= distance(start, pos)) { break; }
+        }
+
+        if (pos != start) { setReadEnd(pos); }
+        return count;
+    }
+
+    auto viewRecord(RecordView& view) -> bool override {
+        while (true) {
+            size_t tail{control().tail_idx.load(etl::memory_order_relaxed)};
+            size_t head{control().head_idx.load(etl::memory_order_acquire)};
+
+            if (tail == head) {
+                if (isUpdatedAfterEmpty(head)) { continue; }
+                return false;
+            }
+
+            RecordHeader header{};
+            size_t next_tail{advance(tail, readRecordHeader(tail, header))};
+
+            // If tail changed - header is invalid, need to retry.
+            if (control().tail_idx.load(etl::memory_order_relaxed) != tail) { continue; }
+
+            if (header.is_padding()) {
+                skipPadding(tail, next_tail);
+                continue;
+            }
+
+            auto span = getSpan(advance(tail, sizeof(RecordHeader)), header.size());
+            view = { span.first, span.first_size, span.second, span.second_size, tail, isGapBefore(tail) };
+            return true;
+        }
+    }
+
+    auto consumeRecord(const RecordView& view) -> bool override {
+        size_t tail{view.index};
+        size_t next_tail{advance(view.index, sizeof(RecordHeader) + view.size())};
+
+        // Fails if tail moved, i.e. writers evicted the record
+        if (!control().tail_idx.compare_exchange_strong(tail, next_tail,
+            etl::memory_order_relaxed, etl::memory_order_relaxed)) { return false; }
+
+        setReadEnd(next_tail);
+        return true;
+    }
+
+    // Copy beginning of the oldest record (up to data capacity), without
+    // removing it from buffer.
+    auto peekRecord(etl::ivector<uint8_t>& data) const -> bool {
+        while (true) {
+            size_t tail{control().tail_idx.load(etl::memory_order_relaxed)};
+            size_t head{control().head_idx.load(etl::memory_order_acquire)};
+
+            if (tail == head) {
+                if (isUpdatedAfterEmpty(head)) { continue; }
+
+                data.clear();
+                return false;
+            }
+
+            size_t pos{tail};
+            RecordHeader header{};
+            size_t record_size{readRecordHeader(pos, header)};
+
+            if (header.is_padding()) {
+                pos = advance(pos, record_size);
+                if (pos == head) {
+                    data.clear();
+                    return false;
+                }
+                readRecordHeader(pos, header);
+            }
+
+            data.resize(etl::min(header.size(), data.capacity()));
+            readBuffer(advance(pos, sizeof(RecordHeader)), data.data(), data.size());
+
+            // If tail changed - data can be invalid, need to retry.
+            if (control().tail_idx.load(etl::memory_order_relaxed) == tail) { return true; }
+        }
+    }
+
+    // Check if span belongs to this buffer
+    auto contains(const RecordSpan& span) const -> bool {
+        return span.first >= storage.data() && span.first < storage.data() + storage.capacity();
+    }
+
+    auto contains(const RecordView& view) const -> bool {
+        return view.first >= storage.data() && view.first < storage.data() + storage.capacity();
+    }
+
+    auto getStats() const -> RingBufferStats override {
+        RingBufferStats stats{};
+        stats.records_written = records_written.load(etl::memory_order_relaxed);
+        stats.bytes_written = bytes_written.load(etl::memory_order_relaxed);
+        stats.records_evicted = records_evicted.load(etl::memory_order_relaxed);
+        stats.allocation_failures = allocation_failures.load(etl::memory_order_relaxed);
+        stats.cas_retries = cas_retries.load(etl::memory_order_relaxed);
+        stats.high_water_mark = high_water_mark.load(etl::memory_order_relaxed);
+        return stats;
+    }
+
+    auto resetStats() -> void override {
+        records_written = 0;
+        bytes_written = 0;
+        records_evicted = 0;
+        allocation_failures = 0;
+        cas_retries = 0;
+        high_water_mark = 0;
+    }
+
+    auto setWaiter(IWaiter* w, size_t watermark = 1) -> void override {
+        waiter = w;
+        waiter_watermark = watermark;
+    }
+
     //
     // Note, this is uncertain feature, to unlock buffer at global fuckup, like
     // watchdog reset. No ideas about real system demands. May be should be done
     // in a different way.
     //
     auto reset(bool unlock_only = false) -> void override {
+        auto& ctrl = control();
+
         if (unlock_only) {
-            writers_count = 0;
-            upcoming_idx = head_idx.load();
+            ctrl.writers_count = 0;
+            ctrl.upcoming_idx = ctrl.head_idx.load();
             return;
         }
 
-        writers_count = 0;
-        tail_idx = 0;
-        head_idx = 0;
-        upcoming_idx = 0;
+        ctrl.writers_count = 0;
+        ctrl.tail_idx = 0;
+        ctrl.head_idx = 0;
+        ctrl.upcoming_idx = 0;
+    }
+
+    //
+    // Restore consistent state of buffer in retained memory, after restart.
+    // Unpublished data (between head and upcoming) is dropped, and records
+    // from tail are validated by headers. Everything after the first broken
+    // one is dropped. Returns number of valid records. Call before use.
+    //
+    auto recover() -> size_t {
+        auto& ctrl = control();
+        size_t tail{ctrl.tail_idx.load()};
+        size_t head{ctrl.head_idx.load()};
+
+        bool valid = FreeRunning
+            ? distance(tail, head) <= storage.capacity()
+            : tail < storage.capacity() && head < storage.capacity();
+
+        if (!valid) {
+            reset();
+            return 0;
+        }
+
+        size_t used{distance(tail, head)};
+        size_t checked{0};
+        size_t pos{tail};
+        size_t count{0};
+
+        while (pos != head) {
+            RecordHeader header{};
+            size_t record_size{readRecordHeader(pos, header)};
+
+            if (checked + record_size > used) { break; }
+            // Padding is written only in contiguous mode, and always up to
+            // buffer end
+            if (header.is_padding() &&
+                (!Contiguous || offsetOf(pos) + record_size != storage.capacity())) { break; }
+
+            checked += record_size;
+            pos = advance(pos, record_size);
+            if (!header.is_padding()) { count++; }
+        }
+
+        ctrl.writers_count = 0;
+        ctrl.head_idx = pos;
+        ctrl.upcoming_idx = pos;
+        return count;
     }
 
 private:
-    static constexpr size_t ALLOCATION_FAILED = static_cast<size_t>(-1);
+    // Power-of-two buffers with size known at compile time use free running
+    // indices (wrapped by mask on access), and can be filled completely.
+    // Others keep indices in [0, capacity), and reserve 1 byte to distinguish
+    // empty from full.
+    static constexpr bool FreeRunning = Storage::FreeRunningIndices;
+    static constexpr size_t Reserved = FreeRunning ? 0 : 1;
+
+    // Try to update head_idx if no more writers are locking buffer.
+    void publish() {
+        auto current_head = control().head_idx.load(etl::memory_order_relaxed);
+        auto current_upcoming = control().upcoming_idx.load(etl::memory_order_relaxed);
+        auto current_writers_count = control().writers_count.fetch_sub(1, etl::memory_order_relaxed);
 
-    // Allocate space for a record, returns the index to write at, or failure
-    size_t allocateSpace(size_t required_size) {
-        if (required_size > etl::numeric_limits<uint16_t>::max()) {
-            return ALLOCATION_FAILED;
+        if (current_writers_count == 1) {
+            if (current_head != current_upcoming) {
+                // If update fails => another writer already did update
+                //
+                // In theory, current_upcoming can become outdated here, but
+                // that will be fixed on next write.
+                if (control().head_idx.compare_exchange_strong(current_head, current_upcoming,
+                    etl::memory_order_release, etl::memory_order_relaxed)) {
+                    notifyWaiter(current_head, current_upcoming);
+                }
+            }
         }
+    }
 
-        while (true) {
-            size_t tail{tail_idx.load(etl::memory_order_relaxed)};
-            size_t upcoming{upcoming_idx.load(etl::memory_order_relaxed)};
-            // Here we use ACQUIRE to sync data for getRecordHeader
-            size_t head{head_idx.load(etl::memory_order_acquire)};
+    //
+    // Reader side. Position after the last read record is remembered, to
+    // detect records, evicted by writers before reader got those.
+    //
+    auto isGapBefore(size_t tail) const -> bool { return has_read && tail != read_end; }
 
-            size_t space_available = upcoming >= tail
-                ? BufferSize - upcoming + tail
-                : tail - upcoming;
+    void setReadEnd(size_t index) {
+        read_end = index;
+        has_read = true;
+    }
 
-            size_t max_available = upcoming >= head
-                ? BufferSize - upcoming + head
-                : head - upcoming;
+    // Reader skips padding itself, that's not a gap
+    void skipPadding(size_t tail, size_t next_tail) {
+        if (control().tail_idx.compare_exchange_strong(tail, next_tail,
+            etl::memory_order_relaxed, etl::memory_order_relaxed) && tail == read_end) {
+            read_end = next_tail;
+        }
+    }
 
-            // Check if we have enough space (after tail cleanup)
-            // + 1 byte reserved, to distinguish empty from full
-            if (required_size + 1 > max_available) {
-                return ALLOCATION_FAILED;
-            }
+    // Wake up reader, if used space crossed watermark
+    void notifyWaiter(size_t old_head, size_t new_head) {
+        if (!waiter) { return; }
 
-            // If current space less that needed - cut tail
-            // + 1 byte reserved, to distinguish empty from full
-            if (required_size + 1 > space_available) {
-                RecordHeader header{};
-                getRecordHeader(tail, header);
-                // Here we can have invalid header, if tail_idx was updated.
-                // But that's safe, because bad value will be ignored by CAS.
-                size_t new_tail{(tail + sizeof(RecordHeader) + header.size) % BufferSize};
+        // Pairs with isUpdatedAfterEmpty()
+        etl::atomic_thread_fence(etl::memory_order_seq_cst);
+        size_t tail{control().tail_idx.load(etl::memory_order_relaxed)};
+
+        if (distance(tail, old_head) < waiter_watermark &&
+            distance(tail, new_head) >= waiter_watermark) {
+            waiter->notify();
+        }
+    }
+
+    // Writer publishes head and then checks tail, reader updates tail and then
+    // checks head. Full barriers on both sides guarantee that at least one of
+    // them sees the other's update, so reader never sleeps with unread data.
+    auto isUpdatedAfterEmpty(size_t head) const -> bool {
+        if (!waiter) { return false; }
+
+        etl::atomic_thread_fence(etl::memory_order_seq_cst);
+        return control().head_idx.load(etl::memory_order_acquire) != head;
+    }
+
+    // Padding before record at given index, to place it in one piece
+    auto paddingAt(size_t index, size_t required_size) const -> size_t {
+        if (!Contiguous) { return 0; }
 
-                tail_idx.compare_exchange_strong(tail, new_tail,
-                    etl::memory_order_relaxed, etl::memory_order_relaxed);
+        size_t offset{offsetOf(index)};
+        return offset + required_size > storage.capacity() ? storage.capacity() - offset : 0;
+    }
+
+    // Allocate space for a record, returns the index to write at
+    auto allocateSpace(size_t required_size, size_t& index) -> bool {
+        if (required_size > sizeof(RecordHeader) + RecordHeader::SizeMask) {
+            return false;
+        }
+
+        // Tail is cached between iterations, and reloaded only when needed.
+        // It never moves back, so outdated value just gives less free space.
+        size_t tail{control().tail_idx.load(etl::memory_order_relaxed)};
+        size_t upcoming{control().upcoming_idx.load(etl::memory_order_relaxed)};
 
-                // Repeat from the beginning, to keep things simple
+        while (true) {
+            size_t padding{paddingAt(upcoming, required_size)};
+            size_t space_available{storage.capacity() - Reserved - distance(tail, upcoming)};
+
+            if (padding + required_size <= space_available) {
+                // Fast path, enough space without eviction
+                size_t new_upcoming{advance(upcoming, padding + required_size)};
+                size_t prev_upcoming{upcoming};
+
+                if (control().upcoming_idx.compare_exchange_strong(upcoming, new_upcoming,
+                    etl::memory_order_relaxed, etl::memory_order_relaxed)) {
+                    updateHighWaterMark(distance(tail, new_upcoming));
+
+                    // Small padding (less than header) is skipped implicitly
+                    if (padding >= sizeof(RecordHeader)) {
+                        setRecordHeader(prev_upcoming, {
+                            static_cast<uint16_t>((padding - sizeof(RecordHeader)) | RecordHeader::PaddingFlag)
+                        });
+                    }
+
+                    index = advance(prev_upcoming, padding);
+                    return true;
+                }
+
+                // Another writer changed upcoming_idx (CAS loaded new value).
+                // Cached tail is still usable, if upcoming did not pass it.
+                cas_retries.fetch_add(1, etl::memory_order_relaxed);
+
+                if (distance(prev_upcoming, upcoming) >= space_available) {
+                    tail = control().tail_idx.load(etl::memory_order_relaxed);
+                }
                 continue;
             }
 
-            // At this place we know that we have enough space.
+            // Slow path. Reload indices, reader could free some space.
+            size_t fresh_tail{control().tail_idx.load(etl::memory_order_relaxed)};
+            upcoming = control().upcoming_idx.load(etl::memory_order_relaxed);
+
+            if (fresh_tail != tail) {
+                tail = fresh_tail;
+                continue;
+            }
 
-            size_t new_upcoming{(upcoming + required_size) % BufferSize};
+            if (Overflow == overflow::drop_newest) { return false; }
 
-            if (!upcoming_idx.compare_exchange_strong(upcoming, new_upcoming,
+            // Here we use ACQUIRE to sync data for getRecordHeader
+            size_t head{control().head_idx.load(etl::memory_order_acquire)};
+
+            // Check if we have enough space (after tail cleanup). Tail is
+            // never ahead of head, so space to head is not less.
+            padding = paddingAt(upcoming, required_size);
+
+            if (padding + required_size > storage.capacity() - Reserved - distance(head, upcoming)) {
+                return false;
+            }
+
+            // Not enough space even after reload - cut tail
+            RecordHeader header{};
+            size_t new_tail{advance(tail, readRecordHeader(tail, header))};
+
+            if (Overflow == overflow::keep_errors && header.is_important()) {
+                // Header can be invalid if tail was updated, check again
+                size_t current{control().tail_idx.load(etl::memory_order_relaxed)};
+                if (current != tail) {
+                    tail = current;
+                    continue;
+                }
+                return false;
+            }
+
+            // Here we can have invalid header, if tail_idx was updated.
+            // But that's safe, because bad value will be ignored by CAS.
+            // On failure CAS loads actual tail.
+            if (control().tail_idx.compare_exchange_strong(tail, new_tail,
                 etl::memory_order_relaxed, etl::memory_order_relaxed)) {
-                // Failed to update upcoming_idx, another writer changed it
-                // => retry
-                continue;
+                if (!header.is_padding()) { records_evicted.fetch_add(1, etl::memory_order_relaxed); }
+                tail = new_tail;
+            } else {
+                cas_retries.fetch_add(1, etl::memory_order_relaxed);
             }
+        }
+    }
+
+    void updateHighWaterMark(size_t used) {
+        size_t current{high_water_mark.load(etl::memory_order_relaxed)};
+
+        // Usually value is not changed, and CAS is not called at all
+        while (used > current && !high_water_mark.compare_exchange_weak(current, used,
+            etl::memory_order_relaxed, etl::memory_order_relaxed)) {}
+    }
+
+    //
+    // Index arithmetic. No division, `n` is never bigger than capacity.
+    //
+
+    // Position in data array
+    inline auto offsetOf(size_t index) const -> size_t {
+        return FreeRunning ? index & (storage.capacity() - 1) : index;
+    }
 
-            // Successfully allocated space
-            return upcoming;
+    inline auto advance(size_t index, size_t n) const -> size_t {
+        if (FreeRunning) { return index + n; }
+
+        size_t result{index + n};
+        return result >= storage.capacity() ? result - storage.capacity() : result;
+    }
+
+    inline auto distance(size_t from, size_t to) const -> size_t {
+        if (FreeRunning) { return to - from; }
+
+        return to >= from ? to - from : storage.capacity() - from + to;
+    }
+
+    // Read header of record at index, returns full record size. In contiguous
+    // mode the last bytes of buffer, too small for header, are padding.
+    inline auto readRecordHeader(size_t index, RecordHeader& header) const -> size_t {
+        if (Contiguous) {
+            size_t left{storage.capacity() - offsetOf(index)};
+
+            if (left < sizeof(RecordHeader)) {
+                header.value = RecordHeader::PaddingFlag;
+                return left;
+            }
         }
+
+        getRecordHeader(index, header);
+        return sizeof(RecordHeader) + header.size();
     }
 
     inline void getRecordHeader(size_t index, RecordHeader& header) const {
@@ -186,31 +837,69 @@ private:
         writeBuffer(index, reinterpret_cast<const uint8_t*>(&header), sizeof(RecordHeader));
     }
 
+    inline auto getSpan(size_t index, size_t size) -> RecordSpan {
+        size_t offset{offsetOf(index)};
+
+        if (offset + size <= storage.capacity()) {
+            return { storage.data() + offset, size, nullptr, 0 };
+        }
+        size_t first_part{storage.capacity() - offset};
+        return { storage.data() + offset, first_part, storage.data(), size - first_part };
+    }
+
     inline void writeBuffer(size_t index, const uint8_t* data, size_t size) {
-        if (index + size <= BufferSize) {
-            etl::copy_n(data, size, &buffer[index]);
+        size_t offset{offsetOf(index)};
+
+        if (offset + size <= storage.capacity()) {
+            etl::copy_n(data, size, storage.data() + offset);
         } else {
-            size_t first_part{BufferSize - index};
-            etl::copy_n(data, first_part, &buffer[index]);
-            etl::copy_n(data + first_part, size - first_part, &buffer[0]);
+            size_t first_part{storage.capacity() - offset};
+            etl::copy_n(data, first_part, storage.data() + offset);
+            etl::copy_n(data + first_part, size - first_part, storage.data());
         }
     }
 
     inline void readBuffer(size_t index, uint8_t* data, size_t size) const {
-        if (index + size <= BufferSize) {
-            etl::copy_n(&buffer[index], size, data);
+        size_t offset{offsetOf(index)};
+
+        if (offset + size <= storage.capacity()) {
+            etl::copy_n(storage.data() + offset, size, data);
         } else {
-            size_t first_part{BufferSize - index};
-            etl::copy_n(&buffer[index], first_part, data);
-            etl::copy_n(&buffer[0], size - first_part, data + first_part);
+            size_t first_part{storage.capacity() - offset};
+            etl::copy_n(storage.data() + offset, first_part, data);
+            etl::copy_n(storage.data(), size - first_part, data + first_part);
         }
     }
 
-    etl::array<uint8_t, BufferSize> buffer{};
-    etl::atomic<size_t> head_idx{0};       // Index visible to readers (published data)
-    etl::atomic<size_t> upcoming_idx{0};   // Index for next allocation (pre-allocated data)
-    etl::atomic<size_t> tail_idx{0};       // Index where reading starts from
-    etl::atomic<size_t> writers_count{0};  // Number of active writers
+    inline auto control() -> typename Storage::Control& { return storage.control(); }
+    inline auto control() const -> const typename Storage::Control& { return storage.control(); }
+
+protected:
+    Storage storage;
+
+private:
+
+    IWaiter* waiter{nullptr};
+    size_t waiter_watermark{1};
+
+    // Reader side, see isGapBefore()
+    size_t read_end{0};
+    bool has_read{false};
+
+    // Stats
+    etl::atomic<size_t> records_written{0};
+    etl::atomic<size_t> bytes_written{0};
+    etl::atomic<size_t> records_evicted{0};
+    etl::atomic<size_t> allocation_failures{0};
+    etl::atomic<size_t> cas_retries{0};
+    etl::atomic<size_t> high_water_mark{0};
 };
 
+template <size_t BufferSize, overflow::Type Overflow = overflow::evict_oldest, bool Contiguous = false>
+using RingBuffer = BasicRingBuffer<ArrayStorage<BufferSize>, Overflow, Contiguous>;
+
+// For multicore hosts, with indices in separate cache lines
+template <size_t BufferSize, overflow::Type Overflow = overflow::evict_oldest, size_t CacheLine = 64>
+using CacheAlignedRingBuffer = BasicRingBuffer<ArrayStorage<BufferSize, CacheLine>, Overflow>;
+
 } // namespace jetlog
\ No newline at end of file
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace jetlog {
+
+//
+// Detects lost records on reader side. Writer with `Sequence` option numbers
+// records, and gaps in numbers show where records were evicted or dropped.
+//
+// The first record after start or reset() is a sync point, numbers before it
+// are not counted (reader can start later than writers, or restart with
+// persistent buffer).
+//
+// Parallel writers can swap records (if one interrupts another between
+// numbering and allocation), so the late one comes after a bigger number.
+// Small gap, not caused by eviction, is held back until the next record, and
+// late records fill it. The rest is reported before the next record, or by
+// pending() when there are no more records.
+//
+class SequenceTracker {
+public:
+    // Number of records missed before the one with `seq`, to report now
+    auto lostBefore(uint32_t seq) const -> uint32_t {
+        if (!synced) { return 0; }
+
+        auto diff = static_cast<int32_t>(seq - expected);
+        if (isLate(diff)) { return 0; }
+
+        return pending() + (isReportedGap(diff) ? static_cast<uint32_t>(diff) : 0);
+    }
+
+    // Register received record
+    void accept(uint32_t seq) {
+        if (!synced) {
+            synced = true;
+            expected = seq + 1;
+            return;
+        }
+
+        auto diff = static_cast<int32_t>(seq - expected);
+
+        // Late record does not move position, but fills the gap
+        if (isLate(diff)) {
+            uint32_t bit{seq - missing_first};
+            if (bit < static_cast<uint32_t>(LateWindow)) { missing &= ~(1u << bit); }
+            return;
+        }
+
+        // Big step back means writer restart (for example, persistent buffer
+        // after reset), resync.
+        missing = 0;
+        if (diff > 0 && !isReportedGap(diff)) {
+            missing_first = expected;
+            missing = (1u << diff) - 1;
+        }
+
+        evicted = false;
+        expected = seq + 1;
+    }
+
+    // Mark gaps before `seq` as reported
+    void skipTo(uint32_t seq) {
+        auto diff = static_cast<int32_t>(seq - expected);
+        if (isReportedGap(diff)) { expected = seq; }
+        missing = 0;
+    }
+
+    // Records were evicted before the next one, its gap can't be filled
+    void markEvicted() { evicted = true; }
+
+    // Held back gap, which is not filled yet
+    auto pending() const -> uint32_t {
+        uint32_t count{0};
+        for (uint32_t bits = missing; bits != 0; bits &= bits - 1) { count++; }
+        return count;
+    }
+
+    void clearPending() { missing = 0; }
+
+    void reset() {
+        expected = 0;
+        missing = 0;
+        synced = false;
+        evicted = false;
+    }
+
+private:
+    static constexpr int32_t LateWindow = 16;
+
+    static auto isLate(int32_t diff) -> bool { return diff < 0 && diff > -LateWindow; }
+
+    auto isReportedGap(int32_t diff) const -> bool {
+        return diff > 0 && (evicted || diff > LateWindow);
+    }
+
+    uint32_t expected{0};
+    // Bit N set - record `missing_first + N` is not received yet
+    uint32_t missing_first{0};
+    uint32_t missing{0};
+    bool synced{false};
+    bool evicted{false};
+};
+
+} // namespace jetlog
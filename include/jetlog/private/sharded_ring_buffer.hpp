@@ -0,0 +1,206 @@
+#pragma once
+
+#include "ring_buffer.hpp"
+#include "types.hpp"
+
+#include <etl/algorithm.h>
+#include <etl/array.h>
+#include <etl/atomic.h>
+#include <etl/limits.h>
+#include <etl/vector.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace jetlog {
+
+// Default shard selector, assigns shards to threads in round-robin order.
+// Slots are never released. When more threads than shards write (see
+// threadsCount()), shards are shared, and writers of the same shard compete
+// as in a single buffer (with the "lost records" edge case). Interrupts use
+// shard of the interrupted thread.
+//
+// On multicore MCUs you may wish to use core ID instead, for example:
+//
+//   struct CoreShardSelector {
+//       static auto index() -> size_t { return xPortGetCoreID(); }
+//   };
+//
+struct ThreadShardSelector {
+    static auto index() -> size_t {
+        static thread_local size_t slot{counter().fetch_add(1, etl::memory_order_relaxed)};
+        return slot;
+    }
+
+    // Number of threads, which got slots. Shards are shared, if bigger than
+    // shards count.
+    static auto threadsCount() -> size_t {
+        return counter().load(etl::memory_order_relaxed);
+    }
+
+private:
+    static auto counter() -> etl::atomic<size_t>& {
+        static etl::atomic<size_t> value{0};
+        return value;
+    }
+};
+
+//
+// Set of independent ring buffers, one per writer group (thread, core). That
+// removes contention between writers and "lost records" edge case of shared
+// buffer, as long as each group has own shard. Groups, mapped to the same
+// shard by ShardSelector, share it silently. Reader gets records from all
+// shards, merged by timestamp.
+//
+// Format - decoder helpers of used data format (IDecoder or ICompactDecoder),
+// to extract timestamps.
+//
+template <
+    size_t Shards,
+    size_t BufferSize,
+    typename ShardSelector = ThreadShardSelector,
+    typename Format = IDecoder
+>
+class ShardedRingBuffer : public IRingBuffer {
+public:
+    static_assert(Shards > 0, "At least one shard required");
+
+    auto writeRecord(const etl::ivector<uint8_t>& data) -> bool final {
+        return currentShard().writeRecord(data);
+    }
+
+    auto writeRecord(const uint8_t* data, size_t size) -> bool final {
+        return currentShard().writeRecord(data, size);
+    }
+
+    auto reserveRecord(size_t size, RecordSpan& span, bool important = false) -> bool final {
+        return currentShard().reserveRecord(size, span, important);
+    }
+
+    auto commitRecord(const RecordSpan& span) -> void final {
+        // Find owner by span, because writer can migrate to another core
+        // between reserve and commit.
+        for (auto& shard : shards) {
+            if (shard.contains(span)) {
+                shard.commitRecord(span);
+                return;
+            }
+        }
+    }
+
+    // Not useful, merged records are not in numbering order
+    auto nextSequence() -> uint32_t final {
+        return sequence.fetch_add(1, etl::memory_order_relaxed);
+    }
+
+    auto readRecord(etl::ivector<uint8_t>& data) -> bool override {
+        size_t selected{selectShard()};
+
+        if (selected == Shards) {
+            data.clear();
+            return false;
+        }
+
+        // Record can be evicted after peek. That's not a problem, we just get
+        // the next one from the same shard.
+        return shards[selected].readRecord(data);
+    }
+
+    auto viewRecord(RecordView& view) -> bool override {
+        size_t selected{selectShard()};
+        return selected != Shards && shards[selected].viewRecord(view);
+    }
+
+    auto consumeRecord(const RecordView& view) -> bool override {
+        for (auto& shard : shards) {
+            if (shard.contains(view)) { return shard.consumeRecord(view); }
+        }
+        return false;
+    }
+
+    // Records should be merged one by one, so this is not faster than
+    // readRecord() loop. Implemented for interface compatibility.
+    auto readRecords(etl::ivector<uint8_t>& data, IRecordConsumer& consumer,
+        size_t max_records = etl::numeric_limits<size_t>::max()) -> size_t override
+    {
+        size_t count{0};
+
+        while (count < max_records && readRecord(data)) {
+            count++;
+            if (!consumer.consume(data)) { break; }
+        }
+        return count;
+    }
+
+    // Sum of all shards. High water mark is the max of shards.
+    auto getStats() const -> RingBufferStats override {
+        RingBufferStats total{};
+
+        for (const auto& shard : shards) {
+            auto stats = shard.getStats();
+            total.records_written += stats.records_written;
+            total.bytes_written += stats.bytes_written;
+            total.records_evicted += stats.records_evicted;
+            total.allocation_failures += stats.allocation_failures;
+            total.cas_retries += stats.cas_retries;
+            total.high_water_mark = etl::max(total.high_water_mark, stats.high_water_mark);
+        }
+        return total;
+    }
+
+    auto resetStats() -> void override {
+        for (auto& shard : shards) { shard.resetStats(); }
+    }
+
+    // Watermark is applied to each shard separately
+    auto setWaiter(IWaiter* waiter, size_t watermark = 1) -> void override {
+        for (auto& shard : shards) { shard.setWaiter(waiter, watermark); }
+    }
+
+    auto reset(bool unlock_only = false) -> void override {
+        for (auto& shard : shards) { shard.reset(unlock_only); }
+    }
+
+    auto shard(size_t idx) -> RingBuffer<BufferSize>& { return shards[idx]; }
+
+private:
+    // Timestamp is the first field in each record. Peek it from all shards
+    // and pick the oldest. Equal timestamps (or no timestamps at all) are
+    // taken in round-robin order, to avoid starvation. Returns Shards if all
+    // are empty.
+    auto selectShard() -> size_t {
+        // Enough for 64-bit timestamp in any format (varint takes up to 10 bytes)
+        etl::vector<uint8_t, Format::MaxHeaderSize + 10> head{};
+
+        size_t selected{Shards};
+        uint64_t selected_time{0};
+
+        for (size_t i{0}; i < Shards; i++) {
+            size_t idx{(next_shard + i) % Shards};
+
+            if (!shards[idx].peekRecord(head)) { continue; }
+
+            uint64_t time{Format::isAvailableAt(head, 0)
+                ? Format::template getAsNum<uint64_t>(head, 0)
+                : etl::numeric_limits<uint64_t>::max()};
+
+            if (selected == Shards || time < selected_time) {
+                selected = idx;
+                selected_time = time;
+            }
+        }
+
+        if (selected != Shards) { next_shard = (selected + 1) % Shards; }
+        return selected;
+    }
+
+    auto currentShard() -> RingBuffer<BufferSize>& {
+        return shards[ShardSelector::index() % Shards];
+    }
+
+    etl::array<RingBuffer<BufferSize>, Shards> shards{};
+    size_t next_shard{0};
+    etl::atomic<uint32_t> sequence{0};
+};
+
+} // namespace jetlog
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <etl/algorithm.h>
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace jetlog {
+
+//
+// Streaming output for Reader. Formatted line is passed in pieces, as soon as
+// those are ready, so reader does not need a buffer for the whole line, and
+// long lines are not truncated.
+//
+class ISink {
+public:
+    virtual void write(const char* data, size_t size) = 0;
+
+    // Pass out buffered data, if any. Called by Reader::drain() after batch.
+    virtual void flush() {}
+};
+
+//
+// Collects small pieces into chunks of fixed size, and passes those to the
+// next sink. For example, to send data via DMA, or to reduce syscalls.
+// Chunk memory is reused after next.write() returns.
+//
+template <size_t ChunkSize>
+class BufferedSink : public ISink {
+public:
+    static_assert(ChunkSize > 0, "Chunk size must be positive");
+
+    explicit BufferedSink(ISink& output) : next{output} {}
+
+    void write(const char* data, size_t size) override {
+        while (size > 0) {
+            size_t chunk{etl::min(size, ChunkSize - used)};
+            etl::copy_n(data, chunk, buffer + used);
+
+            used += chunk;
+            data += chunk;
+            size -= chunk;
+
+            if (used == ChunkSize) { passOut(); }
+        }
+    }
+
+    void flush() override {
+        if (used > 0) { passOut(); }
+        next.flush();
+    }
+
+private:
+    void passOut() {
+        next.write(buffer, used);
+        used = 0;
+    }
+
+    ISink& next;
+    char buffer[ChunkSize];
+    size_t used{0};
+};
+
+} // namespace jetlog
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "compact_types.hpp"
 #include "types.hpp"
 
 namespace jetlog {
@@ -26,8 +27,46 @@ call_encoder(const T&, TOUT&) {
 }
 
 
-template<template<typename> class... Es>
-struct EncoderList {
+// Same for encoded size
+template<template<typename> class E, typename T>
+constexpr auto call_fixed_size() -> typename etl::enable_if<E<T>::matchType, size_t>::type {
+    return E<T>::fixedSize;
+}
+
+template<template<typename> class E, typename T>
+constexpr auto call_fixed_size() -> typename etl::enable_if<!E<T>::matchType, size_t>::type {
+    return 0;
+}
+
+template<template<typename> class E, typename T>
+auto call_dynamic_size(const T& v) -> typename etl::enable_if<E<T>::matchType, size_t>::type {
+    return E<T>::dynamicSize(v);
+}
+
+template<template<typename> class E, typename T>
+auto call_dynamic_size(const T&) -> typename etl::enable_if<!E<T>::matchType, size_t>::type {
+    return 0;
+}
+
+constexpr auto sum() -> size_t { return 0; }
+
+template<typename... Ts>
+constexpr auto sum(size_t first, Ts... rest) -> size_t { return first + sum(rest...); }
+
+
+template<typename StrRef, template<typename> class UInt, template<typename> class... Es>
+struct BasicEncoderList {
+    // Encoder for interned strings (pointers), in the same format
+    using StrRefEncoder = StrRef;
+
+    // Encoder for timestamps, in the same format. Not depends on the list
+    // content, so 64-bit time can be used with 32-bit lists.
+    template<typename T>
+    using TimeEncoder = UInt<T>;
+
+    // Encoder for record sequence numbers
+    using SequenceEncoder = UInt<uint32_t>;
+
     template<typename T>
     struct has_matching_trait {
         static constexpr bool value = bool_or<Es<T>::matchType...>::value;
@@ -40,28 +79,76 @@ struct EncoderList {
         int dummy[] = { (call_encoder<Es, T, TOUT>(value, out), 0)... };
         (void)dummy;
     }
+
+    // Part of encoded size, known at compile time
+    template<typename T>
+    struct fixed_size {
+        static constexpr size_t value = sum(call_fixed_size<Es, T>()...);
+    };
+
+    // Part of encoded size, calculated at runtime (strings length)
+    template<typename T>
+    static auto dynamic_size(const T& value) -> size_t {
+        return sum(call_dynamic_size<Es, T>(value)...);
+    }
+
+    // Total encoded size of all values. Only strings length is calculated
+    // at runtime, everything else is folded to constant.
+    template<typename... Ts>
+    static auto size(const Ts&... values) -> size_t {
+        constexpr size_t fixed{sum(fixed_size<Ts>::value...)};
+        return fixed + sum(dynamic_size(values)...);
+    }
 };
 
 
-template<typename... Ds>
-struct DecoderList {
-    static bool format(const etl::ivector<uint8_t>& data, size_t offset, etl::istring& output, etl::string_view fmt = {}) {
-        if (!IDecoder::isAvailableAt(data, offset)) { return false; }
+template<template<typename> class... Es>
+using EncoderList = BasicEncoderList<EncoderStrRef, EncoderUInt, Es...>;
+
+
+// Helpers - class with static methods to walk encoded data (IDecoder for
+// default format), Unknown - fallback decoder for unsupported types.
+template<typename H, typename Unknown, typename... Ds>
+struct BasicDecoderList {
+    using Helpers = H;
+
+    static bool format(const RecordData& data, size_t offset, etl::istring& output, etl::string_view fmt = {}) {
+        return formatWith(data, offset, output, fmt);
+    }
+
+    // The same, with pre-parsed format
+    static bool format(const RecordData& data, size_t offset, etl::istring& output, const etl::format_spec& spec) {
+        return formatWith(data, offset, output, spec);
+    }
+
+private:
+    template<typename TFMT>
+    static bool formatWith(const RecordData& data, size_t offset, etl::istring& output, const TFMT& fmt) {
+        if (!Helpers::isAvailableAt(data, offset)) { return false; }
 
         bool decoded = false;
 
         int dummy[] = {
-            (Ds::matchTypeTag(IDecoder::readHeader(data, offset).typeId)
+            (Ds::matchTypeTag(Helpers::readHeader(data, offset).typeId)
                  ? (Ds(data, offset).format(output, fmt), decoded = true, 0)
                  : 0)...
         };
         (void)dummy;
 
-        if (!decoded) { DecoderUnknown(data, offset).format(output, fmt); }
+        if (!decoded) { Unknown(data, offset).format(output, fmt); }
         return true;
     }
 };
 
+template<typename... Ds>
+using DecoderList = BasicDecoderList<IDecoder, DecoderUnknown, Ds...>;
+
+template<typename... Ds>
+using CompactDecoderList = BasicDecoderList<ICompactDecoder, CompactDecoderUnknown, Ds...>;
+
+template<template<typename> class... Es>
+using CompactEncoderList = BasicEncoderList<CompactEncoderStrRef, CompactEncoderUInt, Es...>;
+
 
 //
 // Several pre-defined list variants for quick-choose
@@ -69,29 +156,29 @@ struct DecoderList {
 
 using ParamEncoders_32_No_Float = EncoderList<
     EncoderI8, EncoderU8, EncoderI16, EncoderU16, EncoderI32, EncoderU32,
-    EncoderStdString, EncoderCString
+    EncoderStdString, EncoderCString, EncoderStaticStr
 >;
 
 using ParamDecoders_32_No_Float = DecoderList<
     DecoderI8, DecoderU8, DecoderI16, DecoderU16, DecoderI32, DecoderU32,
-    DecoderStr
+    DecoderStr, DecoderStrRef
 >;
 
 using ParamEncoders_32_And_Float = EncoderList<
     EncoderI8, EncoderU8, EncoderI16, EncoderU16, EncoderI32, EncoderU32,
-    EncoderStdString, EncoderCString,
+    EncoderStdString, EncoderCString, EncoderStaticStr,
     EncoderFlt
 >;
 
 using ParamDecoders_32_And_Float = DecoderList<
     DecoderI8, DecoderU8, DecoderI16, DecoderU16, DecoderI32, DecoderU32,
-    DecoderStr,
+    DecoderStr, DecoderStrRef,
     DecoderFlt
 >;
 
 using ParamEncoders_64_And_Double = EncoderList<
     EncoderI8, EncoderU8, EncoderI16, EncoderU16, EncoderI32, EncoderU32,
-    EncoderStdString, EncoderCString,
+    EncoderStdString, EncoderCString, EncoderStaticStr,
     EncoderI64, EncoderU64,
     EncoderFlt,
     EncoderDbl
@@ -99,10 +186,60 @@ using ParamEncoders_64_And_Double = EncoderList<
 
 using ParamDecoders_64_And_Double = DecoderList<
     DecoderI8, DecoderU8, DecoderI16, DecoderU16, DecoderI32, DecoderU32,
-    DecoderStr,
+    DecoderStr, DecoderStrRef,
     DecoderI64, DecoderU64,
     DecoderFlt,
     DecoderDbl
 >;
 
+//
+// Compact variants. Integers are stored as varints, and param header takes
+// 1 byte instead of 3. Must be used in pair (compact encoders with compact
+// decoders).
+//
+
+using CompactParamEncoders_32_No_Float = CompactEncoderList<
+    CompactEncoderI8, CompactEncoderU8, CompactEncoderI16, CompactEncoderU16,
+    CompactEncoderI32, CompactEncoderU32,
+    CompactEncoderStdString, CompactEncoderCString, CompactEncoderStaticStr
+>;
+
+using CompactParamDecoders_32_No_Float = CompactDecoderList<
+    CompactDecoderI8, CompactDecoderU8, CompactDecoderI16, CompactDecoderU16,
+    CompactDecoderI32, CompactDecoderU32,
+    CompactDecoderStr, CompactDecoderStrRef
+>;
+
+using CompactParamEncoders_32_And_Float = CompactEncoderList<
+    CompactEncoderI8, CompactEncoderU8, CompactEncoderI16, CompactEncoderU16,
+    CompactEncoderI32, CompactEncoderU32,
+    CompactEncoderStdString, CompactEncoderCString, CompactEncoderStaticStr,
+    CompactEncoderFlt
+>;
+
+using CompactParamDecoders_32_And_Float = CompactDecoderList<
+    CompactDecoderI8, CompactDecoderU8, CompactDecoderI16, CompactDecoderU16,
+    CompactDecoderI32, CompactDecoderU32,
+    CompactDecoderStr, CompactDecoderStrRef,
+    CompactDecoderFlt
+>;
+
+using CompactParamEncoders_64_And_Double = CompactEncoderList<
+    CompactEncoderI8, CompactEncoderU8, CompactEncoderI16, CompactEncoderU16,
+    CompactEncoderI32, CompactEncoderU32,
+    CompactEncoderStdString, CompactEncoderCString, CompactEncoderStaticStr,
+    CompactEncoderI64, CompactEncoderU64,
+    CompactEncoderFlt,
+    CompactEncoderDbl
+>;
+
+using CompactParamDecoders_64_And_Double = CompactDecoderList<
+    CompactDecoderI8, CompactDecoderU8, CompactDecoderI16, CompactDecoderU16,
+    CompactDecoderI32, CompactDecoderU32,
+    CompactDecoderStr, CompactDecoderStrRef,
+    CompactDecoderI64, CompactDecoderU64,
+    CompactDecoderFlt,
+    CompactDecoderDbl
+>;
+
 } // namespace jetlog
@@ -20,7 +20,53 @@ struct DataHeader {
 };
 
 enum class DataType {
-    I8, U8, I16, U16, I32, U32, I64, U64, Flt, Dbl, Str, LAST
+    I8, U8, I16, U16, I32, U32, I64, U64, Flt, Dbl, Str, StrRef, LAST
+};
+
+// Encoded record bytes for decoders. Points to vector or to ring buffer
+// memory (zero-copy read), converted from vector implicitly.
+//
+// `resolve_refs` - if false, string pointers (StrRef) are not followed, and
+// decoded as "<ref>". Use it for data, which is not validated yet (can be
+// overwritten while reading), or came from other address space.
+class RecordData {
+public:
+    RecordData(const uint8_t* data, size_t size, bool resolve_refs = true)
+        : ptr{data}, length{size}, refs{resolve_refs} {}
+    RecordData(const etl::ivector<uint8_t>& v, bool resolve_refs = true)
+        : ptr{v.data()}, length{v.size()}, refs{resolve_refs} {}
+
+    auto operator[](size_t i) const -> const uint8_t& { return ptr[i]; }
+    auto data() const -> const uint8_t* { return ptr; }
+    auto size() const -> size_t { return length; }
+    auto resolvesRefs() const -> bool { return refs; }
+
+private:
+    const uint8_t* ptr;
+    size_t length;
+    bool refs;
+};
+
+// Text of not resolved string pointer
+constexpr const char* UnresolvedRef = "<ref>";
+
+// Marker for string params with static lifetime (literals, constant tables).
+// Only pointer is stored, without strlen and copy. Reader resolves it back to
+// text, and must be in the same address space as writer.
+//
+//   logWriter.push("", level::info, "State: {}", jetlog::static_str(names[state]));
+//
+struct static_str {
+    explicit constexpr static_str(const char* s) : str{s} {}
+
+    const char* str;
+};
+
+// C string with known length. Writer converts char* params to it, so that
+// strlen is called once per string, and not again on write.
+struct SizedCString {
+    const char* str;
+    size_t length;
 };
 
 struct FormatSpec {
@@ -44,15 +90,79 @@ auto byteswap(T value) -> T {
     return result;
 }
 
+// Little-endian store and load. On little-endian targets those are plain
+// copies, compiled to single (unaligned) memory access.
+template<typename T>
+void storeLE(T value, uint8_t* dst) {
+    static_assert(etl::is_unsigned<T>::value, "Must be unsigned type");
+
+    #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        memcpy(dst, &value, sizeof(T));
+    #else
+        for (size_t i{0}; i < sizeof(T); i++) {
+            dst[i] = static_cast<uint8_t>(value & 0xFF);
+            value = value >> 8;
+        }
+    #endif
+}
+
+// Writes `size` (up to 8) low bytes of word, little-endian. Word is stored
+// at once, so that the copy reads it back without store forwarding stalls.
+template<typename TOUT>
+void writeWord(uint64_t word, size_t size, TOUT& out) {
+    uint8_t bytes[sizeof(uint64_t)];
+    storeLE(word, bytes);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+// Loads `size` bytes (no more than sizeof(T)), upper bytes are zero
+template<typename T>
+auto loadLE(const uint8_t* src, size_t size) -> T {
+    static_assert(etl::is_unsigned<T>::value, "Must be unsigned type");
+
+    T result{0};
+
+    #if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (size == sizeof(T)) {
+            memcpy(&result, src, sizeof(T));
+            return result;
+        }
+    #endif
+
+    for (size_t i{0}; i < size && i < sizeof(T); i++) {
+        result |= static_cast<T>(static_cast<T>(src[i]) << (8 * i));
+    }
+    return result;
+}
+
 
+// Encoded size of param is `fixedSize + dynamicSize(value)`. Fixed part is
+// known at compile time, dynamic part is not zero only for strings.
 class EncoderHelpers {
-protected:
+public:
+    template<typename T>
+    static constexpr auto dynamicSize(const T&) -> size_t { return 0; }
+
     template<typename TOUT>
     static void writeHeader(uint32_t paramTypeID, uint32_t size, TOUT& out) {
-        const uint32_t headerValue = (paramTypeID << 16) | size;
-        out.push_back(static_cast<uint8_t>(headerValue));
-        out.push_back(static_cast<uint8_t>(headerValue >> 8));
-        out.push_back(static_cast<uint8_t>(headerValue >> 16));
+        writeWord(headerWord(paramTypeID, size), DataHeaderSize, out);
+    }
+
+    // Header with fixed size value. Written by words instead of bytes, with
+    // a single bounds check per word.
+    template<typename V, typename TOUT>
+    static void writeFixed(uint32_t paramTypeID, V value, TOUT& out) {
+        // Header and up to 5 bytes of value go in the first word
+        constexpr size_t InFirst = sizeof(V) < 5 ? sizeof(V) : 5;
+        auto val = static_cast<uint64_t>(value);
+
+        writeWord(headerWord(paramTypeID, sizeof(V)) | (val << 24), DataHeaderSize + InFirst, out);
+        if (sizeof(V) > InFirst) { writeWord(val >> (InFirst * 8), sizeof(V) - InFirst, out); }
+    }
+
+private:
+    static auto headerWord(uint32_t paramTypeID, uint32_t size) -> uint64_t {
+        return (static_cast<uint64_t>(paramTypeID) << 16) | size;
     }
 };
 
@@ -64,16 +174,12 @@ public:
         && etl::is_integral<T>::value
         && !(IsSigned ^ etl::is_signed<T>::value);
 
+    static constexpr size_t fixedSize = DataHeaderSize + sizeof(BaseType);
+
     template <typename TOUT>
     static void write(const T& value, TOUT& out) {
-        T val = value;
-
-        writeHeader(static_cast<uint8_t>(TypeId), sizeof(BaseType), out);
-
-        for (size_t i{0}; i < sizeof(BaseType); i++) {
-            out.push_back(static_cast<uint8_t>(val & 0xFF));
-            val = val >> 8;
-        }
+        using UBaseType = typename etl::make_unsigned<BaseType>::type;
+        writeFixed(static_cast<uint8_t>(TypeId), static_cast<UBaseType>(value), out);
     }
 };
 
@@ -102,12 +208,19 @@ using EncoderU32 = EncoderNumeric<T, uint32_t, DataType::U32, false>;
 template <typename T>
 using EncoderU64 = EncoderNumeric<T, uint64_t, DataType::U64, false>;
 
+// Unsigned of any size. Not for params lists, used for timestamps.
+template <typename T>
+using EncoderUInt = EncoderNumeric<T, T,
+    sizeof(T) == 2 ? DataType::U16 : sizeof(T) == 4 ? DataType::U32 : DataType::U64, false>;
+
 
 template <typename T>
 class EncoderFlt : public EncoderHelpers {
 public:
     static constexpr bool matchType = etl::is_same<T, float>::value && sizeof(float) == 4;
 
+    static constexpr size_t fixedSize = DataHeaderSize + sizeof(uint32_t);
+
     template <typename TOUT>
     static void write(const T& value, TOUT& out) {
         // Transform to 4-bytes int
@@ -119,12 +232,7 @@ public:
             result = byteswap(result);
         #endif
 
-        writeHeader(static_cast<uint8_t>(DataType::Flt), sizeof(result), out);
-
-        for (size_t i{0}; i < sizeof(result); i++) {
-            out.push_back(static_cast<uint8_t>(result & 0xFF));
-            result = result >> 8;
-        }
+        writeFixed(static_cast<uint8_t>(DataType::Flt), result, out);
     }
 };
 
@@ -133,6 +241,8 @@ class EncoderDbl : public EncoderHelpers {
 public:
     static constexpr bool matchType = etl::is_same<T, double>::value && sizeof(double) == 8;
 
+    static constexpr size_t fixedSize = DataHeaderSize + sizeof(uint64_t);
+
     template <typename TOUT>
     static void write(const T& value, TOUT& out) {
         // Transform to 8-bytes int
@@ -144,12 +254,7 @@ public:
             result = byteswap(result);
         #endif
 
-        writeHeader(static_cast<uint8_t>(DataType::Dbl), sizeof(result), out);
-
-        for (size_t i{0}; i < sizeof(result); i++) {
-            out.push_back(static_cast<uint8_t>(result & 0xFF));
-            result = result >> 8;
-        }
+        writeFixed(static_cast<uint8_t>(DataType::Dbl), result, out);
     }
 };
 
@@ -175,6 +280,10 @@ public:
         etl::is_class<T>::value &&
         decltype(test<T>(0))::value;
 
+    static constexpr size_t fixedSize = DataHeaderSize;
+
+    static auto dynamicSize(const T& value) -> size_t { return value.length(); }
+
     template <typename TOUT>
     static void write(const T& value, TOUT& out) {
         writeHeader(static_cast<uint8_t>(DataType::Str), value.length(), out);
@@ -189,13 +298,51 @@ class EncoderCString : public EncoderHelpers {
 public:
     static constexpr bool matchType =
         etl::is_same<T, char*>::value ||
-        etl::is_same<T, const char*>::value;
+        etl::is_same<T, const char*>::value ||
+        etl::is_same<T, SizedCString>::value;
+
+    static constexpr size_t fixedSize = DataHeaderSize;
+
+    static auto dynamicSize(const char* value) -> size_t { return strlen(value); }
+    static auto dynamicSize(const SizedCString& value) -> size_t { return value.length; }
 
     template <typename TOUT>
     static void write(const char* value, TOUT& out) {
-        size_t length{strlen(value)};
-        writeHeader(static_cast<uint8_t>(DataType::Str), length, out);
-        out.insert(out.end(), value, value + length);
+        write(SizedCString{value, strlen(value)}, out);
+    }
+
+    template <typename TOUT>
+    static void write(const SizedCString& value, TOUT& out) {
+        writeHeader(static_cast<uint8_t>(DataType::Str), value.length, out);
+        out.insert(out.end(), value.str, value.str + value.length);
+    }
+};
+
+// Encoder for strings with static lifetime (literals). Stores only pointer,
+// and reader resolves it back to text. Works only if reader is in the same
+// address space as writer.
+class EncoderStrRef : public EncoderHelpers {
+public:
+    static constexpr size_t fixedSize = DataHeaderSize + sizeof(uintptr_t);
+
+    template <typename TOUT>
+    static void write(const char* value, TOUT& out) {
+        writeFixed(static_cast<uint8_t>(DataType::StrRef), reinterpret_cast<uintptr_t>(value), out);
+    }
+};
+
+
+// Encoder for static_str params
+template <typename T>
+class EncoderStaticStr : public EncoderHelpers {
+public:
+    static constexpr bool matchType = etl::is_same<T, static_str>::value;
+
+    static constexpr size_t fixedSize = EncoderStrRef::fixedSize;
+
+    template <typename TOUT>
+    static void write(const static_str& value, TOUT& out) {
+        EncoderStrRef::write(value.str, out);
     }
 };
 
@@ -203,11 +350,14 @@ public:
 // Interface for all decoder classes
 class IDecoder {
 public:
+    // Upper bound of param header size
+    enum : size_t { MaxHeaderSize = DataHeaderSize };
+
     static auto matchTypeTag(uint8_t) -> bool {
         assert("This method must be overriden");
     }
 
-    explicit IDecoder(const etl::ivector<uint8_t>& in, uint32_t recordOffset)
+    explicit IDecoder(const RecordData& in, uint32_t recordOffset)
         : input{in}
         , dataOffset{recordOffset + DataHeaderSize}
         , dataSize{readHeader(in, recordOffset).size}
@@ -218,13 +368,19 @@ public:
         assert("This method must be overriden");
     }
 
-    static auto isAvailableAt(const etl::ivector<uint8_t>& in, uint32_t recordOffset) -> bool {
+    // The same, with pre-parsed format
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)out; (void)spec;
+        assert("This method must be overriden");
+    }
+
+    static auto isAvailableAt(const RecordData& in, uint32_t recordOffset) -> bool {
         return (recordOffset + DataHeaderSize <= in.size()) &&
             (recordOffset + DataHeaderSize + readHeader(in, recordOffset).size <= in.size());
     }
 
     template<typename T>
-    static auto getAsNum(const etl::ivector<uint8_t>& in, uint32_t recordOffset) -> T {
+    static auto getAsNum(const RecordData& in, uint32_t recordOffset) -> T {
         static_assert(etl::is_integral<T>::value, "Type must be integral");
 
         if (!isAvailableAt(in, recordOffset)) { return T{0}; }
@@ -232,16 +388,20 @@ public:
         const uint32_t dataOffset = recordOffset + DataHeaderSize;
         const uint32_t dataSize = readHeader(in, recordOffset).size;
 
-        T result = 0;
-        for (size_t i = 0; i < sizeof(T) && i < dataSize; ++i) {
-            result |= static_cast<T>(in[dataOffset + i]) << (8 * i);
-        }
-        return result;
+        using UT = typename etl::make_unsigned<T>::type;
+        return static_cast<T>(loadLE<UT>(in.data() + dataOffset, dataSize));
     }
 
-    static auto getAsStringView(const etl::ivector<uint8_t>& in, uint32_t recordOffset) -> etl::string_view {
+    static auto getAsStringView(const RecordData& in, uint32_t recordOffset) -> etl::string_view {
         if (!isAvailableAt(in, recordOffset)) { return etl::string_view(); }
 
+        if (readHeader(in, recordOffset).typeId == static_cast<uint8_t>(DataType::StrRef)) {
+            if (!in.resolvesRefs()) { return etl::string_view(UnresolvedRef); }
+
+            const auto* str = reinterpret_cast<const char*>(getAsNum<uintptr_t>(in, recordOffset));
+            return str ? etl::string_view(str) : etl::string_view();
+        }
+
         uint32_t dataSize = readHeader(in, recordOffset).size;
         if (dataSize == 0) { return etl::string_view(); }
 
@@ -253,22 +413,27 @@ public:
         );
     }
 
-    static auto getNextOffset(const etl::ivector<uint8_t>& in, uint32_t recordOffset) -> uint32_t {
+    static auto getNextOffset(const RecordData& in, uint32_t recordOffset) -> uint32_t {
         if (recordOffset + DataHeaderSize >= in.size()) { return in.size(); }
 
         return recordOffset + DataHeaderSize + readHeader(in, recordOffset).size;
     }
 
-    static auto readHeader(const etl::ivector<uint8_t>& in, uint32_t recordOffset) -> DataHeader {
+    static auto readHeader(const RecordData& in, uint32_t recordOffset) -> DataHeader {
         return {
             static_cast<uint16_t>(in[recordOffset] | (static_cast<uint16_t>(in[recordOffset + 1]) << 8)),
             static_cast<uint8_t>(in[recordOffset + 2])
         };
     }
 
+    template<typename TOUT>
+    static void writeHeader(uint32_t paramTypeID, uint32_t size, TOUT& out) {
+        EncoderHelpers::writeHeader(paramTypeID, size, out);
+    }
+
 
 protected:
-    const etl::ivector<uint8_t>& input;
+    RecordData input;
     uint32_t dataOffset;
     uint32_t dataSize;
 };
@@ -277,7 +442,7 @@ protected:
 template <typename T, DataType TypeId>
 class DecoderNumeric : public IDecoder {
 public:
-    explicit DecoderNumeric(const etl::ivector<uint8_t>& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
+    explicit DecoderNumeric(const RecordData& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
 
     static auto matchTypeTag(uint8_t ttag) -> bool {
         return ttag == static_cast<uint8_t>(TypeId);
@@ -288,16 +453,17 @@ public:
         etl::format_spec spec;
 
         FormatParser::parse_format(fmt, 0, spec);
+        format(out, spec);
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
         etl::to_string(pickValue(), out, spec, true);
     }
 
 protected:
     auto pickValue() -> T {
-        T val{0};
-        for (size_t i{0}; i < dataSize; i++) {
-            val |= static_cast<T>(input[dataOffset + i]) << (i * 8);
-        }
-        return val;
+        using UT = typename etl::make_unsigned<T>::type;
+        return static_cast<T>(loadLE<UT>(input.data() + dataOffset, dataSize));
     }
 };
 
@@ -320,7 +486,7 @@ using DecoderU64 = DecoderNumeric<uint64_t, DataType::U64>;
 
 class DecoderFlt : public IDecoder {
 public:
-    explicit DecoderFlt(const etl::ivector<uint8_t>& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
+    explicit DecoderFlt(const RecordData& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
 
     static auto matchTypeTag(uint8_t ttag) -> bool {
         return ttag == static_cast<uint8_t>(DataType::Flt);
@@ -332,12 +498,14 @@ public:
         etl::to_string(pickValue(), out, etl::format_spec().precision(6), true);
     }
 
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+
 protected:
     auto pickValue() -> float {
-        uint32_t val{0};
-        for (size_t i{0}; i < dataSize; i++) {
-            val |= static_cast<uint32_t>(input[dataOffset + i]) << (i * 8);
-        }
+        auto val = loadLE<uint32_t>(input.data() + dataOffset, dataSize);
 
         // Convert to big-endian is needed
         #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -352,7 +520,7 @@ protected:
 
 class DecoderDbl : public IDecoder {
 public:
-    explicit DecoderDbl(const etl::ivector<uint8_t>& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
+    explicit DecoderDbl(const RecordData& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
 
     static auto matchTypeTag(uint8_t ttag) -> bool {
         return ttag == static_cast<uint8_t>(DataType::Dbl);
@@ -364,12 +532,14 @@ public:
         etl::to_string(pickValue(), out, etl::format_spec().precision(6), true);
     }
 
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+
 protected:
     auto pickValue() -> double {
-        uint64_t val{0};
-        for (size_t i{0}; i < dataSize; i++) {
-            val |= static_cast<uint64_t>(input[dataOffset + i]) << (i * 8);
-        }
+        auto val = loadLE<uint64_t>(input.data() + dataOffset, dataSize);
 
         // Convert to big-endian is needed
         #if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
@@ -385,7 +555,7 @@ protected:
 // Decoder for strings
 class DecoderStr : public IDecoder {
 public:
-    explicit DecoderStr(const etl::ivector<uint8_t>& in, uint32_t recordOffset)
+    explicit DecoderStr(const RecordData& in, uint32_t recordOffset)
         : IDecoder(in, recordOffset) {}
 
     static auto matchTypeTag(uint8_t ttag) -> bool {
@@ -396,12 +566,44 @@ public:
         (void)fmt;
         out.append(reinterpret_cast<const char*>(&input[dataOffset]), dataSize);
     }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
+};
+
+// Decoder for string pointers (static_str params)
+class DecoderStrRef : public IDecoder {
+public:
+    explicit DecoderStrRef(const RecordData& in, uint32_t recordOffset)
+        : IDecoder(in, recordOffset) {}
+
+    static auto matchTypeTag(uint8_t ttag) -> bool {
+        return ttag == static_cast<uint8_t>(DataType::StrRef);
+    }
+
+    void format(etl::istring& out, etl::string_view fmt = {}) {
+        (void)fmt;
+        if (!input.resolvesRefs()) {
+            out.append(UnresolvedRef);
+            return;
+        }
+
+        const auto* str = reinterpret_cast<const char*>(loadLE<uintptr_t>(input.data() + dataOffset, dataSize));
+        if (str) { out.append(str); }
+    }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
 };
 
 // Fake decoder for unrecognized types
 class DecoderUnknown : public IDecoder {
 public:
-    explicit DecoderUnknown(const etl::ivector<uint8_t>& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
+    explicit DecoderUnknown(const RecordData& in, uint32_t recordOffset) : IDecoder(in, recordOffset) {}
 
     static auto matchTypeTag(uint8_t ttag) -> bool { (void)ttag; return false; }
 
@@ -409,6 +611,11 @@ public:
         (void)fmt;
         out.append("[UNKNOWN]");
     }
+
+    void format(etl::istring& out, const etl::format_spec& spec) {
+        (void)spec;
+        format(out);
+    }
 };
 
 } // namespace jetlog
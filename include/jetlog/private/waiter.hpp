@@ -0,0 +1,25 @@
+#pragma once
+
+#include <stdint.h>
+
+namespace jetlog {
+
+//
+// Reader wakeup on new data, to avoid polling. Ring buffer calls notify()
+// from writer's context (can be interrupt), reader calls wait() when buffer
+// is empty.
+//
+// Implementation must remember notify(), called before wait() (like binary
+// semaphore), in other case wakeup can be lost.
+//
+class IWaiter {
+public:
+    enum : uint32_t { WaitForever = 0xFFFFFFFF };
+
+    virtual void notify() = 0;
+
+    // Returns false on timeout
+    virtual auto wait(uint32_t timeout_ms = WaitForever) -> bool = 0;
+};
+
+} // namespace jetlog
@@ -0,0 +1,47 @@
+#pragma once
+
+//
+// Waiter for hosts with standard threads support (not included by default,
+// because MCU toolchains may have no <condition_variable>).
+//
+// For FreeRTOS, see example with task notifications in `examples` folder.
+//
+
+#include "private/waiter.hpp"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+namespace jetlog {
+
+class StdWaiter : public IWaiter {
+public:
+    void notify() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            signaled = true;
+        }
+        cv.notify_one();
+    }
+
+    auto wait(uint32_t timeout_ms = WaitForever) -> bool override {
+        std::unique_lock<std::mutex> lock(mutex);
+
+        if (timeout_ms == WaitForever) {
+            cv.wait(lock, [this] { return signaled; });
+        } else if (!cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] { return signaled; })) {
+            return false;
+        }
+
+        signaled = false;
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool signaled{false};
+};
+
+} // namespace jetlog
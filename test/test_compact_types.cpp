@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+
+#include "jetlog/private/compact_types.hpp"
+#include "jetlog/private/typelists.hpp"
+#include "jetlog/jetlog.hpp"
+
+#include <etl/to_arithmetic.h>
+
+using namespace jetlog;
+using Encoders = jetlog::CompactParamEncoders_64_And_Double;
+
+TEST(CompactTypesTest, SmallIntegers) {
+    etl::vector<uint8_t, 100> buffer{};
+
+    // Small values take 2 bytes, independent on type width
+    Encoders::write(uint8_t{5}, buffer);
+    Encoders::write(int32_t{-5}, buffer);
+    Encoders::write(uint64_t{100}, buffer);
+    EXPECT_EQ(buffer.size(), 6u);
+
+    EXPECT_EQ(ICompactDecoder::readHeader(buffer, 0).typeId, static_cast<uint8_t>(DataType::U8));
+    EXPECT_EQ(ICompactDecoder::readHeader(buffer, 2).typeId, static_cast<uint8_t>(DataType::I32));
+    EXPECT_EQ(ICompactDecoder::getAsNum<int32_t>(buffer, 2), -5);
+    EXPECT_EQ(ICompactDecoder::getAsNum<uint64_t>(buffer, 4), 100u);
+    EXPECT_EQ(ICompactDecoder::getNextOffset(buffer, 4), 6u);
+}
+
+TEST(CompactTypesTest, WireFormat) {
+    etl::vector<uint8_t, 100> buffer{};
+
+    Encoders::write(uint32_t{300}, buffer);
+    Encoders::write(1.0f, buffer);
+
+    const uint8_t expected[] = {
+        static_cast<uint8_t>(static_cast<uint8_t>(DataType::U32) << 4 | 2), 0xAC, 0x02,
+        static_cast<uint8_t>(static_cast<uint8_t>(DataType::Flt) << 4 | 4), 0x00, 0x00, 0x80, 0x3F
+    };
+    ASSERT_EQ(buffer.size(), sizeof(expected));
+    EXPECT_TRUE(etl::equal(buffer.begin(), buffer.end(), expected));
+}
+
+TEST(CompactTypesTest, IntegerLimits) {
+    etl::vector<uint8_t, 100> buffer{};
+    etl::string<100> result;
+
+    Encoders::write(INT32_MIN, buffer);
+    CompactDecoderI32(buffer, 0).format(result);
+    EXPECT_EQ(result, "-2147483648");
+
+    buffer.clear(); result.clear();
+    Encoders::write(INT64_MAX, buffer);
+    CompactDecoderI64(buffer, 0).format(result);
+    EXPECT_EQ(result, "9223372036854775807");
+
+    buffer.clear(); result.clear();
+    Encoders::write(UINT64_MAX, buffer);
+    EXPECT_EQ(buffer.size(), 11u);
+    CompactDecoderU64(buffer, 0).format(result);
+    EXPECT_EQ(result, "18446744073709551615");
+
+    buffer.clear(); result.clear();
+    Encoders::write(int8_t{-128}, buffer);
+    CompactDecoderI8(buffer, 0).format(result);
+    EXPECT_EQ(result, "-128");
+}
+
+TEST(CompactTypesTest, FloatAndDouble) {
+    etl::vector<uint8_t, 100> buffer{};
+    etl::string<100> result;
+
+    Encoders::write(123.456f, buffer);
+    EXPECT_EQ(buffer.size(), 5u);
+    CompactDecoderFlt(buffer, 0).format(result);
+    EXPECT_NEAR(etl::to_arithmetic<float>(result), 123.456f, 0.0001f);
+
+    buffer.clear(); result.clear();
+    Encoders::write(123.456789, buffer);
+    EXPECT_EQ(buffer.size(), 9u);
+    CompactDecoderDbl(buffer, 0).format(result);
+    EXPECT_NEAR(etl::to_arithmetic<double>(result), 123.456789, 0.000001);
+}
+
+TEST(CompactTypesTest, Strings) {
+    etl::vector<uint8_t, 100> buffer{};
+    etl::string<100> result;
+
+    // Short string - size in header byte
+    const char* short_str = "Hello";
+    Encoders::write(short_str, buffer);
+    EXPECT_EQ(buffer.size(), 6u);
+    CompactDecoderStr(buffer, 0).format(result);
+    EXPECT_EQ(result, "Hello");
+
+    // Long string - size in varint after header byte
+    buffer.clear(); result.clear();
+    std::string long_str(20, 'x');
+    Encoders::write(long_str, buffer);
+    EXPECT_EQ(buffer.size(), 22u);
+    EXPECT_EQ(ICompactDecoder::readHeader(buffer, 0).headerSize, 2u);
+    CompactDecoderStr(buffer, 0).format(result);
+    EXPECT_EQ(result, long_str.c_str());
+
+    buffer.clear();
+    std::string empty_str;
+    Encoders::write(empty_str, buffer);
+    EXPECT_EQ(buffer.size(), 1u);
+    EXPECT_EQ(ICompactDecoder::getAsStringView(buffer, 0).length(), 0u);
+}
+
+TEST(CompactTypesTest, EncodedSize) {
+    etl::vector<uint8_t, 300> buffer{};
+    const int16_t i16_val = -5;
+    const uint32_t u32_val = 100000;
+    const double dbl_val = 1.5;
+    const char* str_val = "test";
+    std::string long_str(200, 'x');
+
+    Encoders::write(i16_val, buffer);
+    Encoders::write(u32_val, buffer);
+    Encoders::write(dbl_val, buffer);
+    Encoders::write(str_val, buffer);
+    Encoders::write(long_str, buffer);
+
+    EXPECT_EQ(Encoders::size(i16_val, u32_val, dbl_val, str_val, long_str), buffer.size());
+}
+
+TEST(CompactTypesTest, BrokenData) {
+    etl::vector<uint8_t, 100> buffer{};
+
+    Encoders::write(std::string(20, 'x'), buffer);
+
+    // Cut inside data
+    buffer.resize(10);
+    EXPECT_FALSE(ICompactDecoder::isAvailableAt(buffer, 0));
+
+    // Cut inside varint size
+    buffer.resize(1);
+    EXPECT_FALSE(ICompactDecoder::isAvailableAt(buffer, 0));
+    EXPECT_EQ(ICompactDecoder::getAsStringView(buffer, 0).length(), 0u);
+}
+
+TEST(CompactTypesTest, WriterReaderRoundTrip) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::CompactParamEncoders_32_And_Float> logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::CompactParamDecoders_32_And_Float> logReader(ringBuffer);
+    etl::string<100> output;
+    etl::vector<uint8_t, 256> record;
+
+    logWriter.push("Tag", jetlog::level::warn, "Values: {} {:x} {} {}", 7, 255u, -1, "str");
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+    // ts(6) + tag(4) + level(2) + message(2 + 21) + args(2 + 3 + 2 + 4)
+    EXPECT_EQ(record.size(), 46u);
+
+    logWriter.push("Tag", jetlog::level::warn, "Values: {} {:x} {} {}", 7, 255u, -1, "str");
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "W Tag: Values: 7 ff -1 str");
+}
+
+TEST(CompactTypesTest, InternedStrings) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::CompactParamEncoders_32_And_Float, true> logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::CompactParamDecoders_32_And_Float> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.push("Tag", jetlog::level::info, "Interned {}", 5);
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I Tag: Interned 5");
+}
+
+TEST(CompactTypesTest, StaticStrParams) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::CompactParamEncoders_32_And_Float> logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::CompactParamDecoders_32_And_Float> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.push("Tag", jetlog::level::info, "State: {} {}", jetlog::static_str("Running"), 5);
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I Tag: State: Running 5");
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+
+using jetlog::FormatCache;
+
+TEST(FormatCacheTest, ParseSegments) {
+    FormatCache<4> cache;
+
+    const auto* entry = cache.get("Value: {:04x}, {}!");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->segments_count, 5u);
+
+    EXPECT_FALSE(entry->segments[0].is_placeholder);
+    EXPECT_EQ(entry->segments[0].offset, 0u);
+    EXPECT_EQ(entry->segments[0].length, 7u);
+
+    EXPECT_TRUE(entry->segments[1].is_placeholder);
+    EXPECT_EQ(entry->segments[1].offset, 7u);
+    EXPECT_EQ(entry->segments[1].length, 6u);
+    EXPECT_EQ(entry->segments[1].spec.get_base(), 16u);
+    EXPECT_EQ(entry->segments[1].spec.get_width(), 4u);
+    EXPECT_EQ(entry->segments[1].spec.get_fill(), '0');
+
+    EXPECT_TRUE(entry->segments[3].is_placeholder);
+    EXPECT_EQ(entry->segments[3].spec.get_base(), 10u);
+
+    EXPECT_FALSE(entry->segments[4].is_placeholder);
+    EXPECT_EQ(entry->segments[4].length, 1u);
+}
+
+TEST(FormatCacheTest, HitAndReplace) {
+    FormatCache<1> cache;
+
+    // Different buffers with the same content must hit the same entry
+    etl::string<50> first = "Hello {}";
+    etl::string<50> second = "Hello {}";
+
+    const auto* entry = cache.get(first);
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(cache.get(second), entry);
+
+    // Single slot => replaced by another format
+    entry = cache.get("Other {} {}");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->segments_count, 4u);
+}
+
+TEST(FormatCacheTest, HashCollision) {
+    FormatCache<1> cache;
+
+    // Same FNV-1a hash and length, different segments
+    ASSERT_EQ(FormatCache<1>::fnv1a("{:x} eeet"), FormatCache<1>::fnv1a("{} qotaa!"));
+
+    const auto* entry = cache.get("{:x} eeet");
+    ASSERT_NE(entry, nullptr);
+    EXPECT_EQ(entry->segments[0].length, 4u);
+    EXPECT_EQ(entry->segments[0].spec.get_base(), 16u);
+
+    entry = cache.get("{} qotaa!");
+    ASSERT_NE(entry, nullptr);
+    ASSERT_EQ(entry->segments_count, 2u);
+    EXPECT_EQ(entry->segments[0].length, 2u);
+    EXPECT_EQ(entry->segments[0].spec.get_base(), 10u);
+    EXPECT_EQ(entry->segments[1].length, 7u);
+}
+
+TEST(FormatCacheTest, Rollback) {
+    FormatCache<4> cache;
+
+    // Entry filled after the count is dropped
+    auto fills = cache.fills();
+    ASSERT_NE(cache.get("Value {}"), nullptr);
+    EXPECT_EQ(cache.fills(), fills + 1);
+    cache.rollback(fills);
+
+    fills = cache.fills();
+    ASSERT_NE(cache.get("Value {}"), nullptr);
+    EXPECT_EQ(cache.fills(), fills + 1);
+
+    // Nothing filled since the count, hit stays
+    fills = cache.fills();
+    ASSERT_NE(cache.get("Value {}"), nullptr);
+    cache.rollback(fills);
+    ASSERT_NE(cache.get("Value {}"), nullptr);
+    EXPECT_EQ(cache.fills(), fills);
+}
+
+TEST(FormatCacheTest, TooManySegments) {
+    FormatCache<4, 2> cache;
+    EXPECT_EQ(cache.get("a {} b"), nullptr);
+    EXPECT_NE(cache.get("a {}"), nullptr);
+    EXPECT_NE(cache.get(""), nullptr);
+
+    // Too long to keep a copy
+    FormatCache<4, 16, 8> shortCache;
+    EXPECT_EQ(shortCache.get("Value {}!"), nullptr);
+    EXPECT_NE(shortCache.get("Value {}"), nullptr);
+}
+
+TEST(FormatCacheTest, ReaderWithCache) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, FormatCache<8>> logReader(ringBuffer);
+    etl::string<100> output;
+
+    for (int i = 0; i < 3; i++) {
+        logWriter.push("", jetlog::level::info, "{} {:#X} {:4d} {:z} {}", 123, 255, 42, 1);
+        output.clear();
+        ASSERT_TRUE(logReader.pull(output));
+        // Invalid placeholder is printed as is
+        EXPECT_EQ(output, "I: 123 0XFF   42 {:z} 1");
+    }
+
+    for (int i = 0; i < 2; i++) {
+        logWriter.push("", jetlog::level::info, "No params {}");
+        output.clear();
+        ASSERT_TRUE(logReader.pull(output));
+        EXPECT_EQ(output, "I: No params {}");
+    }
+}
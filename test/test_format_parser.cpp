@@ -5,7 +5,7 @@ class HeadlessReader : public jetlog::Reader<> {
 public:
     HeadlessReader(jetlog::IRingBuffer& buf) : jetlog::Reader<>(buf) {}
 
-    void writeLogHeader(etl::istring& output, uint32_t timestamp, const etl::string_view& tag, uint8_t level) override {
+    void writeLogHeader(etl::istring& output, uint64_t timestamp, const etl::string_view& tag, uint8_t level) override {
         (void)output; (void)timestamp; (void)tag; (void)level;
     }
 };
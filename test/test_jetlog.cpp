@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "jetlog/jetlog.hpp"
 
+#include <string>
+
 TEST(JetlogTest, BasicPush) {
     jetlog::RingBuffer<10000> ringBuffer;
     jetlog::Writer<> logWriter(ringBuffer);
@@ -65,6 +67,782 @@ TEST(JetlogTest, TimestampAndTag) {
     EXPECT_EQ(output, "I (12345) TestTag: Message with timestamp and tag");
 }
 
+struct MockClock {
+    using Type = uint64_t;
+    static uint64_t time;
+    auto now() -> uint64_t { return time; }
+};
+
+uint64_t MockClock::time = 0;
+
+TEST(JetlogTest, Clock64) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false, jetlog::level::verbose, 0, MockClock> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    // 64-bit time works with 32-bit params list
+    MockClock::time = 0x123456789ull;
+    logWriter.push("", jetlog::level::info, "Message");
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I (4886718345): Message");
+}
+
+TEST(JetlogTest, DeltaTime) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false, jetlog::level::verbose, 0, MockClock, true> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    etl::vector<uint8_t, 256> record;
+
+    // First record in period has full time, next ones - only low 16 bits
+    MockClock::time = 0x10000FFF0ull;
+    logWriter.push("", jetlog::level::info, "Message");
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+    size_t full_size{record.size()};
+
+    logWriter.push("", jetlog::level::info, "Message");
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+    EXPECT_EQ(full_size - record.size(), 6u);
+
+    // Reader restores full time, including records after period change
+    std::vector<std::string> lines;
+    for (uint64_t t : {0x10001FFF0ull, 0x10001FFFFull, 0x100020005ull, 0x100020006ull, 0x100040000ull}) {
+        MockClock::time = t;
+        logWriter.push("", jetlog::level::info, "Message");
+    }
+    while (logReader.pull(output)) {
+        lines.push_back(output.c_str());
+        output.clear();
+    }
+
+    std::vector<std::string> expected{
+        "I (4295098352): Message",
+        "I (4295098367): Message",
+        "I (4295098373): Message",
+        "I (4295098374): Message",
+        "I (4295229440): Message"
+    };
+    EXPECT_EQ(lines, expected);
+}
+
+TEST(JetlogTest, DeltaTimeDecoder) {
+    jetlog::TimestampDecoder decoder;
+    etl::vector<uint8_t, 16> field;
+
+    auto decode = [&](auto value) {
+        field.clear();
+        jetlog::EncoderUInt<decltype(value)>::write(value, field);
+        return decoder.decode<jetlog::IDecoder>(field, 0);
+    };
+
+    // No reference yet
+    EXPECT_EQ(decode(uint16_t{5}), static_cast<uint64_t>(jetlog::TimestampDecoder::NoTime));
+    // Default clock without time
+    EXPECT_EQ(decode(uint32_t{0xFFFFFFFF}), static_cast<uint64_t>(jetlog::TimestampDecoder::NoTime));
+
+    EXPECT_EQ(decode(uint32_t{0x2FFF0}), 0x2FFF0u);
+    // Crossed period border without sync (sync record evicted), upper bits
+    // are unknown
+    EXPECT_EQ(decode(uint16_t{0x0010}), static_cast<uint64_t>(jetlog::TimestampDecoder::NoTime));
+    EXPECT_EQ(decode(uint16_t{0xFFF8}), 0x2FFF8u);
+
+    // Slightly out of order, back to previous period
+    EXPECT_EQ(decode(uint32_t{0x30002}), 0x30002u);
+    EXPECT_EQ(decode(uint16_t{0xFFFA}), 0x2FFFAu);
+    EXPECT_EQ(decode(uint16_t{0x0005}), 0x30005u);
+
+    // Sync record evicted, more than half a period later
+    EXPECT_EQ(decode(uint16_t{0x7000}), 0x37000u);
+    EXPECT_EQ(decode(uint16_t{0xE000}), 0x3E000u);
+    EXPECT_EQ(decode(uint16_t{0xFFF0}), 0x3FFF0u);
+    EXPECT_EQ(decode(uint16_t{0x002F}), static_cast<uint64_t>(jetlog::TimestampDecoder::NoTime));
+
+    // Reference dropped after lost records
+    decoder.reset();
+    EXPECT_EQ(decode(uint16_t{0xFFF1}), static_cast<uint64_t>(jetlog::TimestampDecoder::NoTime));
+    EXPECT_EQ(decode(uint32_t{0x50000}), 0x50000u);
+    EXPECT_EQ(decode(uint16_t{0x0010}), 0x50010u);
+
+    // Sparse records, more than half a period apart
+    EXPECT_EQ(decode(uint32_t{0x60100}), 0x60100u);
+    EXPECT_EQ(decode(uint16_t{0x9000}), 0x69000u);
+    EXPECT_EQ(decode(uint16_t{0xF000}), 0x6F000u);
+}
+
+TEST(JetlogTest, DeltaTimeSparse) {
+    jetlog::RingBuffer<256> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false, jetlog::level::verbose, 0, MockClock, true> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    std::vector<std::string> lines;
+
+    for (uint64_t time : { 0x10100, 0x19000, 0x1F000, 0x20010 }) {
+        MockClock::time = time;
+        logWriter.push("", jetlog::level::info, "Message");
+    }
+
+    logReader.drain(output, [&lines](const etl::istring& line) { lines.emplace_back(line.c_str()); });
+    EXPECT_EQ(lines, (std::vector<std::string>{
+        "I (65792): Message", "I (102400): Message", "I (126976): Message", "I (131088): Message" }));
+}
+
+TEST(JetlogTest, DeltaTimeAfterEviction) {
+    jetlog::RingBuffer<256> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false, jetlog::level::verbose, 0, MockClock, true> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    MockClock::time = 0x20010;
+    logWriter.push("", jetlog::level::info, "Message");
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I (131088): Message");
+
+    // Full time record of the next period is evicted. Low bits of the rest
+    // fit the previous period, but upper bits are unknown.
+    MockClock::time = 0x50000;
+    logWriter.push("", jetlog::level::info, "Sync");
+    MockClock::time = 0x5002F;
+    for (int i = 0; i < 30; i++) { logWriter.push("", jetlog::level::info, "Message"); }
+
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Message");
+
+    // Restored from the next full time
+    while (logReader.pull(output)) {}
+    MockClock::time = 0x60001;
+    logWriter.push("", jetlog::level::info, "Message");
+    MockClock::time = 0x60002;
+    logWriter.push("", jetlog::level::info, "Message");
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I (393218): Message");
+}
+
+TEST(JetlogTest, TypedBufferWriter) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::BasicWriter<jetlog::RingBuffer<10000>> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    EXPECT_TRUE(logWriter.push("TestTag", jetlog::level::info, "Value: {}", 5));
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I TestTag: Value: 5");
+
+    // Sharded buffer
+    jetlog::ShardedRingBuffer<2, 1024> shardedBuffer;
+    jetlog::BasicWriter<jetlog::ShardedRingBuffer<2, 1024>> shardedWriter(shardedBuffer);
+    jetlog::Reader<> shardedReader(shardedBuffer);
+
+    output.clear();
+    EXPECT_TRUE(shardedWriter.push("", jetlog::level::warn, "Value: {}", 6));
+    ASSERT_TRUE(shardedReader.pull(output));
+    EXPECT_EQ(output, "W: Value: 6");
+}
+
+TEST(JetlogTest, TruncatedRecord) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<32> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    EXPECT_FALSE(logWriter.push("", jetlog::level::info, "Too long message for small record {}", 1));
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: [TRUNCATED]");
+
+    output.clear();
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Short {}", 1));
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Short 1");
+}
+
+TEST(JetlogTest, InternedStrings) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, true> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    etl::vector<uint8_t, 256> record;
+
+    // Tag and message are stored as pointers, independent on text length
+    logWriter.push("TestTag", jetlog::level::info, "Interned message {}", 5);
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+    EXPECT_EQ(record.size(), 7u + 2 * (3 + sizeof(uintptr_t)) + 4u + 7u);
+
+    logWriter.push("TestTag", jetlog::level::info, "Interned message {}", 5);
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I TestTag: Interned message 5");
+}
+
+TEST(JetlogTest, StaticStrParams) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    etl::vector<uint8_t, 256> record;
+
+    static const char* states[] = { "Idle", "Running", "A very long state description" };
+
+    // Record size does not depend on string length
+    logWriter.push("", jetlog::level::info, "{}", jetlog::static_str(states[0]));
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+    auto short_size = record.size();
+
+    logWriter.push("", jetlog::level::info, "{}", jetlog::static_str(states[2]));
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+    EXPECT_EQ(record.size(), short_size);
+
+    logWriter.push("", jetlog::level::info, "State: {}, next: {}", jetlog::static_str(states[1]), "Idle");
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: State: Running, next: Idle");
+}
+
+TEST(JetlogTest, Drain) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    std::vector<std::string> lines;
+
+    for (int i = 0; i < 3; i++) {
+        logWriter.push("", jetlog::level::info, "Record {}", i);
+    }
+
+    auto count = logReader.drain(output, [&lines](const etl::istring& line) {
+        lines.emplace_back(line.c_str());
+    });
+
+    EXPECT_EQ(count, 3u);
+    EXPECT_EQ(lines, (std::vector<std::string>{ "I: Record 0", "I: Record 1", "I: Record 2" }));
+    EXPECT_FALSE(logReader.pull(output));
+}
+
+TEST(JetlogTest, LevelFilter) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.setLevel(jetlog::level::info);
+    EXPECT_EQ(logWriter.getLevel(), jetlog::level::info);
+
+    EXPECT_FALSE(logWriter.push("", jetlog::level::debug, "Skipped"));
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Written"));
+
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Written");
+    EXPECT_FALSE(logReader.pull(output));
+}
+
+TEST(JetlogTest, TagFilter) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false, jetlog::level::verbose, 2> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.setLevel(jetlog::level::warn);
+    EXPECT_TRUE(logWriter.setTagLevel("net", jetlog::level::debug));
+    EXPECT_TRUE(logWriter.setTagLevel("fs", jetlog::level::error));
+    EXPECT_FALSE(logWriter.setTagLevel("ui", jetlog::level::error));
+    // Update of existing tag is always possible
+    EXPECT_TRUE(logWriter.setTagLevel("fs", jetlog::level::warn));
+
+    EXPECT_TRUE(logWriter.push("net", jetlog::level::debug, "Net debug"));
+    EXPECT_FALSE(logWriter.push("fs", jetlog::level::info, "Fs info"));
+    EXPECT_TRUE(logWriter.push("fs", jetlog::level::warn, "Fs warn"));
+    EXPECT_FALSE(logWriter.push("other", jetlog::level::info, "Other info"));
+
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "D net: Net debug");
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "W fs: Fs warn");
+    EXPECT_FALSE(logReader.pull(output));
+}
+
+TEST(JetlogTest, CompileTimeLevel) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false, jetlog::level::info> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    EXPECT_FALSE(logWriter.push<jetlog::level::verbose>("", "Removed {}", 1));
+    EXPECT_TRUE(logWriter.push<jetlog::level::info>("", "Kept {}", 2));
+
+    // Runtime level can't exceed compile-time limit
+    logWriter.setLevel(jetlog::level::verbose);
+    EXPECT_EQ(logWriter.getLevel(), jetlog::level::info);
+    EXPECT_FALSE(logWriter.push("", jetlog::level::debug, "Removed"));
+
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Kept 2");
+    EXPECT_FALSE(logReader.pull(output));
+}
+
+TEST(JetlogTest, KeepErrorsOnOverflow) {
+    jetlog::RingBuffer<200, jetlog::overflow::keep_errors> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.push("", jetlog::level::error, "Fault {}", 1);
+    for (uint32_t i = 0; i < 50; i++) {
+        logWriter.push("", jetlog::level::info, "Storm {}", i);
+    }
+
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "E: Fault 1");
+}
+
+TEST(JetlogTest, PullInPlaceAndWrapped) {
+    jetlog::RingBuffer<64> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    // Records pass buffer end at different offsets, both in place
+    // and copy paths must give the same result
+    for (int i = 0; i < 20; i++) {
+        logWriter.push("", jetlog::level::info, "Record {}", i);
+        output.clear();
+        ASSERT_TRUE(logReader.pull(output));
+        EXPECT_EQ(output, "I: Record " + std::to_string(i));
+    }
+}
+
+// Record is overwritten while reader formats it in place, or evicted after
+// reader took its sequence number (on the n-th view)
+class OverwrittenRingBuffer : public jetlog::RingBuffer<256> {
+public:
+    auto consumeRecord(const jetlog::RecordView& view) -> bool override {
+        bool consumed{jetlog::RingBuffer<256>::consumeRecord(view)};
+        if (overwrite) {
+            overwrite = false;
+            return false;
+        }
+        return consumed;
+    }
+
+    auto viewRecord(jetlog::RecordView& view) -> bool override {
+        bool result{jetlog::RingBuffer<256>::viewRecord(view)};
+        if (evictOnView > 0 && --evictOnView == 0) { view.index++; }
+        return result;
+    }
+
+    bool overwrite{false};
+    int evictOnView{0};
+};
+
+TEST(JetlogTest, PullOverwrittenInPlace) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    OverwrittenRingBuffer ringBuffer;
+    SeqWriter logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.push("", jetlog::level::info, "Record {}", 0);
+    ASSERT_TRUE(logReader.pull(output));
+    logWriter.push("", jetlog::level::info, "Record {}", 1);
+    logWriter.push("", jetlog::level::info, "Record {}", 2);
+
+    // Sequence number of dropped record is not accepted
+    ringBuffer.overwrite = true;
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "W: 1 records lost");
+
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Record 2");
+}
+
+namespace {
+
+// Format cache of the last created reader, to check its entries
+struct ProbeCache : public jetlog::FormatCache<4> {
+    ProbeCache() { last = this; }
+    static ProbeCache* last;
+};
+
+ProbeCache* ProbeCache::last{nullptr};
+
+} // namespace
+
+TEST(JetlogTest, PullOverwrittenDropsCacheEntry) {
+    OverwrittenRingBuffer ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, ProbeCache> logReader(ringBuffer);
+    etl::string<100> output;
+
+    logWriter.push("", jetlog::level::info, "Hex {:x}", 255u);
+    logWriter.push("", jetlog::level::info, "Other");
+
+    // Entry, parsed from overwritten record, is not kept
+    ringBuffer.overwrite = true;
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Other");
+
+    // Entry of valid record stays (formats are in different slots)
+    auto& cache = *ProbeCache::last;
+    auto fills = cache.fills();
+    ASSERT_NE(cache.get("Other"), nullptr);
+    EXPECT_EQ(cache.fills(), fills);
+
+    ASSERT_NE(cache.get("Hex {:x}"), nullptr);
+    EXPECT_EQ(cache.fills(), fills + 1);
+}
+
+TEST(JetlogTest, LostReportAfterValidation) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    OverwrittenRingBuffer ringBuffer;
+    SeqWriter logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    etl::vector<uint8_t, 256> skipped;
+
+    logWriter.push("", jetlog::level::info, "Record {}", 0);
+    ASSERT_TRUE(logReader.pull(output));
+    logWriter.push("", jetlog::level::info, "Record {}", 1);
+    logWriter.push("", jetlog::level::info, "Record {}", 2);
+    // Record 1 is evicted
+    ringBuffer.readRecord(skipped);
+    logReader.markGap();
+
+    // Gap is still reported, if the first check failed
+    ringBuffer.evictOnView = 2;
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "W: 1 records lost");
+
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Record 2");
+}
+
+TEST(JetlogTest, SequenceSharedByWriters) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    jetlog::RingBuffer<1024> ringBuffer;
+    SeqWriter netWriter(ringBuffer);
+    SeqWriter uiWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    std::vector<std::string> lines;
+
+    netWriter.push("net", jetlog::level::info, "Record {}", 0);
+    uiWriter.push("ui", jetlog::level::info, "Record {}", 1);
+    netWriter.push("net", jetlog::level::info, "Record {}", 2);
+
+    EXPECT_EQ(logReader.drain(output, [&lines](const etl::istring& line) {
+        lines.emplace_back(line.c_str());
+    }), 3u);
+    EXPECT_EQ(lines, (std::vector<std::string>{ "I net: Record 0", "I ui: Record 1", "I net: Record 2" }));
+}
+
+TEST(JetlogTest, SequenceGaps) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    jetlog::RingBuffer<256> ringBuffer;
+    SeqWriter logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    std::vector<std::string> lines;
+
+    auto onLine = [&lines](const etl::istring& line) { lines.emplace_back(line.c_str()); };
+
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", 0));
+    EXPECT_EQ(logReader.drain(output, onLine), 1u);
+
+    // Old records are evicted, reader reports how many
+    for (int i = 1; i < 20; i++) {
+        logWriter.push("", jetlog::level::info, "Record {}", i);
+    }
+    auto count = logReader.drain(output, onLine);
+
+    ASSERT_EQ(lines.size(), count + 2);
+    EXPECT_EQ(lines[0], "I: Record 0");
+    EXPECT_EQ(lines[1], "W: " + std::to_string(19 - count) + " records lost");
+    EXPECT_EQ(lines[2], "I: Record " + std::to_string(20 - count));
+    EXPECT_EQ(lines.back(), "I: Record 19");
+
+    // Filtered records are not numbered
+    logWriter.setLevel(jetlog::level::info);
+    EXPECT_FALSE(logWriter.push("", jetlog::level::debug, "Skipped"));
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", 20));
+
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Record 20");
+    EXPECT_FALSE(logReader.pull(output));
+}
+
+TEST(JetlogTest, SequenceDropNewestCompact) {
+    using SeqWriter = jetlog::Writer<256, jetlog::CompactParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    jetlog::RingBuffer<64, jetlog::overflow::drop_newest> ringBuffer;
+    SeqWriter logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::CompactParamDecoders_32_And_Float> logReader(ringBuffer);
+    etl::string<100> output;
+
+    // The first ones stay, the rest are rejected
+    size_t written{0};
+    for (int i = 0; i < 10; i++) {
+        if (logWriter.push("", jetlog::level::info, "Record {}", i)) { written++; }
+    }
+    ASSERT_GT(written, 0u);
+    ASSERT_LT(written, 10u);
+
+    for (size_t i = 0; i < written; i++) {
+        output.clear();
+        ASSERT_TRUE(logReader.pull(output));
+        EXPECT_EQ(output, "I: Record " + std::to_string(i));
+    }
+
+    // Late records can't fill the gap after the next written one, it's
+    // reported when no more records left
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", 10));
+
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Record 10");
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "W: " + std::to_string(10 - written) + " records lost");
+    EXPECT_FALSE(logReader.pull(output));
+}
+
+TEST(JetlogTest, SequenceTracker) {
+    jetlog::SequenceTracker tracker;
+
+    EXPECT_EQ(tracker.lostBefore(0), 0u);
+    tracker.accept(0);
+
+    // Small gap waits for late records, reported before the next record
+    EXPECT_EQ(tracker.lostBefore(3), 0u);
+    tracker.accept(3);
+    EXPECT_EQ(tracker.pending(), 2u);
+    EXPECT_EQ(tracker.lostBefore(4), 2u);
+    tracker.skipTo(4);
+    tracker.accept(4);
+    EXPECT_EQ(tracker.pending(), 0u);
+
+    // Late records from preempted writers fill it and don't move position
+    tracker.accept(7);
+    EXPECT_EQ(tracker.lostBefore(6), 0u);
+    tracker.accept(6);
+    tracker.accept(5);
+    EXPECT_EQ(tracker.lostBefore(8), 0u);
+    tracker.accept(8);
+
+    // Partially filled
+    tracker.accept(12);
+    tracker.accept(10);
+    EXPECT_EQ(tracker.lostBefore(13), 2u);
+    tracker.skipTo(13);
+    tracker.accept(13);
+
+    // Eviction and big gap are reported at once
+    tracker.markEvicted();
+    EXPECT_EQ(tracker.lostBefore(15), 1u);
+    tracker.skipTo(15);
+    tracker.accept(15);
+    EXPECT_EQ(tracker.lostBefore(100), 84u);
+    tracker.skipTo(100);
+    tracker.accept(100);
+    EXPECT_EQ(tracker.pending(), 0u);
+
+    // Writer restarted
+    tracker.accept(1000);
+    tracker.accept(0);
+    EXPECT_EQ(tracker.lostBefore(1), 0u);
+
+    // Counter overflow
+    tracker.accept(0xFFFFFFF0);
+    tracker.accept(0xFFFFFFFF);
+    tracker.clearPending();
+    tracker.accept(1);
+    EXPECT_EQ(tracker.pending(), 1u);
+
+    // The first record is a sync point, numbers before it are not lost
+    jetlog::SequenceTracker late;
+    EXPECT_EQ(late.lostBefore(500), 0u);
+    late.accept(500);
+    late.accept(502);
+    EXPECT_EQ(late.pending(), 1u);
+
+    late.reset();
+    EXPECT_EQ(late.lostBefore(900), 0u);
+    late.accept(900);
+    EXPECT_EQ(late.lostBefore(901), 0u);
+}
+
+TEST(JetlogTest, JsonOutput) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    TimestampedWriter logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, jetlog::NoFormatCache, jetlog::JsonFormatter> logReader(ringBuffer);
+    etl::string<200> output;
+
+    logWriter.push("net", jetlog::level::warn, "Sent {} to {}, rate {}", -512, "srv", 1.5f);
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "{\"ts\":12345,\"level\":\"warn\",\"tag\":\"net\",\"msg\":\"Sent {} to {}, rate {}\","
+        "\"args\":[-512,\"srv\",1.500000]}");
+
+    // Escaping, not representable values, interned strings
+    output.clear();
+    logWriter.push("", jetlog::level::error, "Quote \"{}\"", "a\\b\n\x01", std::numeric_limits<float>::quiet_NaN(),
+        jetlog::static_str("static"));
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "{\"ts\":12345,\"level\":\"error\",\"tag\":\"\",\"msg\":\"Quote \\\"{}\\\"\","
+        "\"args\":[\"a\\\\b\\n\\u0001\",null,\"static\"]}");
+
+    // No time, no params
+    jetlog::Writer<> plainWriter(ringBuffer);
+    output.clear();
+    plainWriter.push("", jetlog::level::info, "Plain");
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "{\"level\":\"info\",\"tag\":\"\",\"msg\":\"Plain\",\"args\":[]}");
+
+    // Line fits exactly
+    etl::string<49> exactOutput;
+    plainWriter.push("", jetlog::level::info, "Plain");
+    ASSERT_TRUE(logReader.pull(exactOutput));
+    EXPECT_EQ(exactOutput, "{\"level\":\"info\",\"tag\":\"\",\"msg\":\"Plain\",\"args\":[]}");
+
+    // Line does not fit
+    etl::string<48> shortOutput;
+    plainWriter.push("", jetlog::level::info, "Plain");
+    EXPECT_FALSE(logReader.pull(shortOutput));
+}
+
+TEST(JetlogTest, JsonLostRecords) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    jetlog::RingBuffer<64, jetlog::overflow::drop_newest> ringBuffer;
+    SeqWriter logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, jetlog::NoFormatCache, jetlog::JsonFormatter> logReader(ringBuffer);
+    etl::string<200> output;
+
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", 0));
+    EXPECT_FALSE(logWriter.push("", jetlog::level::info, "Record {}", 1));
+    ASSERT_TRUE(logReader.pull(output));
+
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", 2));
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "{\"level\":\"info\",\"tag\":\"\",\"msg\":\"Record {}\",\"args\":[2]}");
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "{\"lost\":1}");
+}
+
+namespace {
+
+struct StringSink : public jetlog::ISink {
+    void write(const char* data, size_t size) override { text.append(data, size); }
+    void flush() override { flushes++; }
+
+    std::string text;
+    int flushes{0};
+};
+
+} // namespace
+
+TEST(JetlogTest, SinkOutput) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<1024> logWriter(ringBuffer);
+    jetlog::Reader<1024> logReader(ringBuffer);
+    StringSink sink;
+
+    // Longer than formatter buffers, not truncated
+    std::string longParam(500, 'x');
+    logWriter.push("tag", jetlog::level::info, "Long {} and {:#b}", longParam.c_str(), 0xFFFFFFFFu);
+    ASSERT_TRUE(logReader.pull(sink));
+    EXPECT_EQ(sink.text, "I tag: Long " + longParam + " and 0b" + std::string(32, '1') + "\n");
+
+    sink.text.clear();
+    for (int i = 0; i < 3; i++) {
+        logWriter.push("", jetlog::level::info, "Record {}", i);
+    }
+
+    EXPECT_EQ(logReader.drain(sink), 3u);
+    EXPECT_EQ(sink.text, "I: Record 0\nI: Record 1\nI: Record 2\n");
+    EXPECT_EQ(sink.flushes, 1);
+    EXPECT_FALSE(logReader.pull(sink));
+}
+
+TEST(JetlogTest, SinkLongTagAndWidth) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<1024> logWriter(ringBuffer);
+    jetlog::Reader<1024> logReader(ringBuffer);
+    jetlog::Reader<1024, jetlog::ParamDecoders_32_And_Float, jetlog::FormatCache<4>> cachedReader(ringBuffer);
+    StringSink sink;
+
+    // Tag and padding are wider than sink buffer, not cut
+    std::string tag(120, 't');
+    std::string expected{"I " + tag + ": " + std::string(98, '0') + "ab [" + std::string(89, ' ') + "7]\n"};
+
+    logWriter.push(tag.c_str(), jetlog::level::info, "{:0100x} [{:90d}]", 0xABu, 7);
+    ASSERT_TRUE(logReader.pull(sink));
+    EXPECT_EQ(sink.text, expected);
+
+    // The same with pre-parsed format
+    sink.text.clear();
+    logWriter.push(tag.c_str(), jetlog::level::info, "{:0100x} [{:90d}]", 0xABu, 7);
+    ASSERT_TRUE(cachedReader.pull(sink));
+    EXPECT_EQ(sink.text, expected);
+
+    // String output gives the same
+    etl::string<400> output;
+    logWriter.push(tag.c_str(), jetlog::level::info, "{:0100x} [{:90d}]", 0xABu, 7);
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(std::string(output.c_str()) + "\n", expected);
+}
+
+TEST(JetlogTest, SinkJsonAndLostRecords) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    jetlog::RingBuffer<64, jetlog::overflow::drop_newest> ringBuffer;
+    SeqWriter logWriter(ringBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, jetlog::NoFormatCache, jetlog::JsonFormatter> logReader(ringBuffer);
+    StringSink sink;
+
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", "a\"b"));
+    EXPECT_FALSE(logWriter.push("", jetlog::level::info, "Record {}", 1));
+    ASSERT_TRUE(logReader.pull(sink));
+    EXPECT_EQ(sink.text, "{\"level\":\"info\",\"tag\":\"\",\"msg\":\"Record {}\",\"args\":[\"a\\\"b\"]}\n");
+
+    // Escaped string longer than formatter buffer
+    jetlog::RingBuffer<1024> bigBuffer;
+    jetlog::Writer<> bigWriter(bigBuffer);
+    jetlog::Reader<256, jetlog::ParamDecoders_32_And_Float, jetlog::NoFormatCache, jetlog::JsonFormatter> bigReader(bigBuffer);
+    std::string escaped;
+    for (int i = 0; i < 30; i++) { escaped += "\n\x01"; }
+
+    sink.text.clear();
+    bigWriter.push("", jetlog::level::info, "{}", escaped.c_str());
+    ASSERT_TRUE(bigReader.pull(sink));
+    std::string expected;
+    for (int i = 0; i < 30; i++) { expected += "\\n\\u0001"; }
+    EXPECT_EQ(sink.text, "{\"level\":\"info\",\"tag\":\"\",\"msg\":\"{}\",\"args\":[\"" + expected + "\"]}\n");
+
+    sink.text.clear();
+    EXPECT_TRUE(logWriter.push("", jetlog::level::info, "Record {}", 2));
+    // Lost line is not counted
+    EXPECT_EQ(logReader.drain(sink), 1u);
+    EXPECT_EQ(sink.text, "{\"level\":\"info\",\"tag\":\"\",\"msg\":\"Record {}\",\"args\":[2]}\n{\"lost\":1}\n");
+}
+
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
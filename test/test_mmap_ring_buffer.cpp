@@ -0,0 +1,204 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+#include "jetlog/mmap_ring_buffer.hpp"
+
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TempFile {
+    TempFile() {
+        snprintf(path, sizeof(path), "/tmp/jetlog_test_%d.bin", static_cast<int>(getpid()));
+        unlink(path);
+    }
+    ~TempFile() { unlink(path); }
+
+    char path[64];
+};
+
+} // namespace
+
+TEST(MmapRingBufferTest, CreateAndAttach) {
+    TempFile file;
+    etl::vector<uint8_t, 100> data(10, 1);
+    etl::vector<uint8_t, 100> readData{};
+
+    jetlog::MmapRingBuffer<> owner(file.path, 4096);
+    ASSERT_TRUE(owner.isOpen());
+
+    // Second mapping of the same file
+    jetlog::MmapRingBuffer<> attached(file.path);
+    ASSERT_TRUE(attached.isOpen());
+
+    ASSERT_TRUE(attached.writeRecord(data));
+    ASSERT_TRUE(owner.readRecord(readData));
+    EXPECT_EQ(readData, data);
+    EXPECT_FALSE(attached.readRecord(readData));
+}
+
+TEST(MmapRingBufferTest, AttachInvalid) {
+    TempFile file;
+
+    // No file
+    jetlog::MmapRingBuffer<> missing(file.path);
+    EXPECT_FALSE(missing.isOpen());
+
+    // File without buffer must stay untouched
+    FILE* f = fopen(file.path, "wb");
+    ASSERT_NE(f, nullptr);
+    char garbage[256] = "not a buffer";
+    fwrite(garbage, 1, sizeof(garbage), f);
+    fclose(f);
+
+    jetlog::MmapRingBuffer<> invalid(file.path);
+    EXPECT_FALSE(invalid.isOpen());
+
+    f = fopen(file.path, "rb");
+    ASSERT_NE(f, nullptr);
+    char content[256] = {};
+    EXPECT_EQ(fread(content, 1, sizeof(content), f), sizeof(content));
+    fclose(f);
+    EXPECT_STREQ(content, "not a buffer");
+}
+
+TEST(MmapRingBufferTest, CrossProcess) {
+    TempFile file;
+    jetlog::MmapRingBuffer<> ringBuffer(file.path, 64 * 1024);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        jetlog::MmapRingBuffer<> childBuffer(file.path);
+        jetlog::Writer<> logWriter(childBuffer);
+        for (uint32_t i = 0; i < 100; i++) {
+            logWriter.push("child", jetlog::level::info, "Record {}", i);
+        }
+        _exit(childBuffer.isOpen() ? 0 : 1);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    size_t count = 0;
+    while (logReader.pull(output)) {
+        EXPECT_EQ(output, ("I child: Record " + std::to_string(count)).c_str());
+        output.clear();
+        count++;
+    }
+    EXPECT_EQ(count, 100u);
+}
+
+TEST(MmapRingBufferTest, PointersNotFollowed) {
+    TempFile file;
+    jetlog::MmapRingBuffer<> ringBuffer(file.path, 4096);
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+    std::vector<std::string> lines;
+
+    // Pointer could come from another process
+    EXPECT_TRUE(ringBuffer.isShared());
+    logWriter.push("", jetlog::level::info, "State: {}", jetlog::static_str("Idle"));
+    logWriter.push("", jetlog::level::info, "State: {}", jetlog::static_str("Running"));
+
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: State: <ref>");
+
+    logReader.drain(output, [&lines](const etl::istring& line) { lines.emplace_back(line.c_str()); });
+    EXPECT_EQ(lines, (std::vector<std::string>{ "I: State: <ref>" }));
+}
+
+TEST(MmapRingBufferTest, RecoverOnReopen) {
+    TempFile file;
+    etl::vector<uint8_t, 100> data(10, 1);
+    etl::vector<uint8_t, 100> readData{};
+
+    {
+        jetlog::MmapRingBuffer<> ringBuffer(file.path, 4096);
+        ASSERT_TRUE(ringBuffer.writeRecord(data));
+    }
+
+    jetlog::MmapRingBuffer<> ringBuffer(file.path, 4096);
+    ASSERT_TRUE(ringBuffer.readRecord(readData));
+    EXPECT_EQ(readData, data);
+}
+
+TEST(MmapRingBufferTest, UnlockStalled) {
+    TempFile file;
+    jetlog::MmapRingBuffer<> ringBuffer(file.path, 64 * 1024);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    // Child dies between reserve and commit
+    pid_t pid = fork();
+    ASSERT_GE(pid, 0);
+
+    if (pid == 0) {
+        jetlog::MmapRingBuffer<> childBuffer(file.path);
+        jetlog::RecordSpan span{};
+        _exit(childBuffer.reserveRecord(10, span) ? 0 : 1);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    ASSERT_TRUE(WIFEXITED(status));
+    ASSERT_EQ(WEXITSTATUS(status), 0);
+
+    // Records of alive writers are not published
+    jetlog::Writer<> logWriter(ringBuffer);
+    logWriter.push("", jetlog::level::info, "After crash");
+    EXPECT_FALSE(logReader.pull(output));
+
+    // The first call only remembers state
+    EXPECT_FALSE(ringBuffer.unlockStalled());
+    EXPECT_TRUE(ringBuffer.unlockStalled());
+    EXPECT_FALSE(ringBuffer.unlockStalled());
+
+    // Incomplete record of dead writer goes first
+    jetlog::RecordView view{};
+    ASSERT_TRUE(ringBuffer.viewRecord(view));
+    EXPECT_EQ(view.size(), 10u);
+    EXPECT_TRUE(ringBuffer.consumeRecord(view));
+
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: After crash");
+
+    // Works as usual after unlock
+    output.clear();
+    logWriter.push("", jetlog::level::info, "Next");
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Next");
+}
+
+TEST(MmapRingBufferTest, NoUnlockWhileActive) {
+    TempFile file;
+    jetlog::MmapRingBuffer<> ringBuffer(file.path, 4096);
+    etl::vector<uint8_t, 100> data(10, 1);
+
+    // Published index moves between calls
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(ringBuffer.writeRecord(data));
+        EXPECT_FALSE(ringBuffer.unlockStalled());
+    }
+
+    // Writer is inside at one call only
+    jetlog::RecordSpan span{};
+    ASSERT_TRUE(ringBuffer.reserveRecord(10, span));
+    EXPECT_FALSE(ringBuffer.unlockStalled());
+    ringBuffer.commitRecord(span);
+    EXPECT_FALSE(ringBuffer.unlockStalled());
+}
+
+#endif
@@ -0,0 +1,193 @@
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+#include "jetlog/private/persistent_ring_buffer.hpp"
+
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Simulates retained memory. Filled with garbage, like RAM on cold start.
+struct RetainedMemory {
+    RetainedMemory() { memset(data, 0xA5, sizeof(data)); }
+
+    alignas(8) uint8_t data[256];
+};
+
+} // namespace
+
+TEST(PersistentRingBufferTest, ColdStart) {
+    RetainedMemory memory;
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    etl::vector<uint8_t, 100> readData{};
+
+    EXPECT_EQ(buffer.recoveredRecords(), 0u);
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
+
+TEST(PersistentRingBufferTest, RecoverAfterRestart) {
+    RetainedMemory memory;
+    etl::vector<uint8_t, 100> data1(10, 1);
+    etl::vector<uint8_t, 100> data2(20, 2);
+    etl::vector<uint8_t, 100> readData{};
+
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+        ASSERT_TRUE(buffer.writeRecord(data1));
+        ASSERT_TRUE(buffer.writeRecord(data2));
+    }
+
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    EXPECT_EQ(buffer.recoveredRecords(), 2u);
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, data1);
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, data2);
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
+
+TEST(PersistentRingBufferTest, NoLostRecordsAfterRestart) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    RetainedMemory memory;
+    etl::string<100> output;
+
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+        SeqWriter logWriter(buffer);
+        jetlog::Reader<> logReader(buffer);
+
+        for (int i = 0; i < 3; i++) {
+            logWriter.push("", jetlog::level::info, "Record {}", i);
+            output.clear();
+            ASSERT_TRUE(logReader.pull(output));
+        }
+    }
+
+    // New reader starts from the next number, earlier ones were read before
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    SeqWriter logWriter(buffer);
+    jetlog::Reader<> logReader(buffer);
+
+    logWriter.push("", jetlog::level::info, "Record {}", 3);
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Record 3");
+}
+
+TEST(PersistentRingBufferTest, SwappedRecordsNotLost) {
+    using SeqWriter = jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, false,
+        jetlog::level::verbose, 0, jetlog::VirtualClock, false, true>;
+
+    RetainedMemory memory;
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    SeqWriter logWriter(buffer);
+    jetlog::Reader<> logReader(buffer);
+    etl::string<100> output;
+    std::vector<std::string> lines;
+    auto& sequence = reinterpret_cast<jetlog::MemoryStorage::Header*>(memory.data)->control.sequence;
+
+    logWriter.push("", jetlog::level::info, "Record {}", 0);
+    ASSERT_TRUE(logReader.pull(output));
+
+    // Writer took number 1 and was interrupted before allocation, another
+    // one took number 2 and wrote its record first
+    sequence = 2;
+    logWriter.push("", jetlog::level::info, "Record {}", 2);
+    sequence = 1;
+    logWriter.push("", jetlog::level::info, "Record {}", 1);
+    sequence = 3;
+    logWriter.push("", jetlog::level::info, "Record {}", 3);
+
+    logReader.drain(output, [&lines](const etl::istring& line) { lines.emplace_back(line.c_str()); });
+    EXPECT_EQ(lines, (std::vector<std::string>{ "I: Record 2", "I: Record 1", "I: Record 3" }));
+
+    // Not filled gap is reported
+    sequence = 5;
+    logWriter.push("", jetlog::level::info, "Record {}", 5);
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "I: Record 5");
+    output.clear();
+    ASSERT_TRUE(logReader.pull(output));
+    EXPECT_EQ(output, "W: 1 records lost");
+}
+
+TEST(PersistentRingBufferTest, DropUnpublished) {
+    RetainedMemory memory;
+    jetlog::RecordSpan span{};
+    etl::vector<uint8_t, 100> data(10, 1);
+    etl::vector<uint8_t, 100> readData{};
+
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+        ASSERT_TRUE(buffer.writeRecord(data));
+        // Crash in the middle of write, record is not committed
+        ASSERT_TRUE(buffer.reserveRecord(30, span));
+    }
+
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    EXPECT_EQ(buffer.recoveredRecords(), 1u);
+
+    // Buffer is not locked by dead writer
+    ASSERT_TRUE(buffer.writeRecord(data));
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
+
+TEST(PersistentRingBufferTest, BrokenRecord) {
+    RetainedMemory memory;
+    etl::vector<uint8_t, 100> data(10, 1);
+    etl::vector<uint8_t, 100> readData{};
+
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+        ASSERT_TRUE(buffer.writeRecord(data));
+        ASSERT_TRUE(buffer.writeRecord(data));
+    }
+
+    // Damage size of the second record
+    size_t second = sizeof(jetlog::MemoryStorage::Header) + 2 + 10;
+    memory.data[second] = 0xFF;
+
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    EXPECT_EQ(buffer.recoveredRecords(), 1u);
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, data);
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
+
+TEST(PersistentRingBufferTest, BrokenControlBlock) {
+    RetainedMemory memory;
+    etl::vector<uint8_t, 100> data(10, 1);
+    etl::vector<uint8_t, 100> readData{};
+
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+        ASSERT_TRUE(buffer.writeRecord(data));
+    }
+
+    // Different size (firmware update) => start from scratch
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data) - 8);
+        EXPECT_EQ(buffer.recoveredRecords(), 0u);
+        EXPECT_FALSE(buffer.readRecord(readData));
+    }
+
+    // Indices out of range
+    {
+        jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+        ASSERT_TRUE(buffer.writeRecord(data));
+    }
+    reinterpret_cast<jetlog::MemoryStorage::Header*>(memory.data)->control.head_idx = 10000;
+
+    jetlog::PersistentRingBuffer<> buffer(memory.data, sizeof(memory.data));
+    EXPECT_EQ(buffer.recoveredRecords(), 0u);
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+auto decodeStream(const etl::ivector<uint8_t>& stream, jetlog::RawFrameDecoder<>& decoder) -> std::vector<std::string> {
+    jetlog::RecordFormatter<jetlog::ParamDecoders_64_And_Double> formatter;
+    std::vector<std::string> lines;
+
+    for (auto byte : stream) {
+        if (decoder.feed(byte)) {
+            // The same as host decoder, pointers from stream are not followed
+            etl::string<200> line;
+            EXPECT_TRUE(formatter.formatRecord(jetlog::RecordData{decoder.record(), false}, line));
+            lines.emplace_back(line.c_str());
+        }
+    }
+    return lines;
+}
+
+} // namespace
+
+TEST(RawFrameTest, ExportAndDecode) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::RawReader<> rawReader(ringBuffer);
+    etl::vector<uint8_t, 1000> stream;
+
+    logWriter.push("Tag", jetlog::level::info, "Value {}, {}", 5, "text");
+    logWriter.push("", jetlog::level::error, "Second");
+
+    ASSERT_TRUE(rawReader.pull(stream));
+    ASSERT_TRUE(rawReader.pull(stream));
+    ASSERT_FALSE(rawReader.pull(stream));
+
+    jetlog::RawFrameDecoder<> decoder;
+    auto lines = decodeStream(stream, decoder);
+
+    EXPECT_EQ(lines, (std::vector<std::string>{ "I Tag: Value 5, text", "E: Second" }));
+    EXPECT_EQ(decoder.errors(), 0u);
+}
+
+TEST(RawFrameTest, InternedStringsExpanded) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<256, jetlog::ParamEncoders_32_And_Float, true> logWriter(ringBuffer);
+    jetlog::RawReader<> rawReader(ringBuffer);
+    etl::vector<uint8_t, 1000> stream;
+
+    logWriter.push("Tag", jetlog::level::info, "Interned {}", 5);
+    ASSERT_TRUE(rawReader.pull(stream));
+
+    jetlog::RawFrameDecoder<> decoder;
+
+    // Pointers must not leave device
+    jetlog::RawFrameDecoder<> checker;
+    for (auto byte : stream) {
+        if (!checker.feed(byte)) { continue; }
+
+        const auto& record = checker.record();
+        for (uint32_t offset = 0; jetlog::IDecoder::isAvailableAt(record, offset);
+            offset = jetlog::IDecoder::getNextOffset(record, offset))
+        {
+            EXPECT_NE(jetlog::IDecoder::readHeader(record, offset).typeId,
+                static_cast<uint8_t>(jetlog::DataType::StrRef));
+        }
+    }
+
+    EXPECT_EQ(decodeStream(stream, decoder), (std::vector<std::string>{ "I Tag: Interned 5" }));
+}
+
+TEST(RawFrameTest, ForeignPointerNotFollowed) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    etl::vector<uint8_t, 256> record;
+    etl::vector<uint8_t, 1000> stream;
+
+    // Well-formed frame with pointer (noise, or frame not from RawReader)
+    logWriter.push("", jetlog::level::info, "State: {}", jetlog::static_str(reinterpret_cast<const char*>(0x10)));
+    ASSERT_TRUE(ringBuffer.readRecord(record));
+
+    stream.push_back(jetlog::RawFrame::Sync1);
+    stream.push_back(jetlog::RawFrame::Sync2);
+    stream.push_back(static_cast<uint8_t>(record.size()));
+    stream.push_back(static_cast<uint8_t>(record.size() >> 8));
+    stream.insert(stream.end(), record.begin(), record.end());
+
+    uint8_t crc{0};
+    for (size_t i = 2; i < stream.size(); i++) { crc = jetlog::RawFrame::crc8(crc, stream[i]); }
+    stream.push_back(crc);
+
+    jetlog::RawFrameDecoder<> decoder;
+    EXPECT_EQ(decodeStream(stream, decoder), (std::vector<std::string>{ "I: State: <ref>" }));
+}
+
+TEST(RawFrameTest, ResyncAfterGarbage) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::RawReader<> rawReader(ringBuffer);
+    etl::vector<uint8_t, 1000> stream;
+
+    // Garbage with sync bytes before frame
+    stream.push_back(0x00);
+    stream.push_back(jetlog::RawFrame::Sync1);
+    stream.push_back(jetlog::RawFrame::Sync1);
+
+    logWriter.push("", jetlog::level::info, "First");
+    ASSERT_TRUE(rawReader.pull(stream));
+
+    // Broken frame
+    logWriter.push("", jetlog::level::info, "Broken");
+    size_t broken_pos = stream.size();
+    ASSERT_TRUE(rawReader.pull(stream));
+    stream[broken_pos + 10] ^= 0xFF;
+
+    logWriter.push("", jetlog::level::info, "Last");
+    ASSERT_TRUE(rawReader.pull(stream));
+
+    jetlog::RawFrameDecoder<> decoder;
+    EXPECT_EQ(decodeStream(stream, decoder), (std::vector<std::string>{ "I: First", "I: Last" }));
+    EXPECT_EQ(decoder.errors(), 1u);
+}
+
+TEST(RawFrameTest, NoSpaceInOutput) {
+    jetlog::RingBuffer<10000> ringBuffer;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::RawReader<> rawReader(ringBuffer);
+    etl::vector<uint8_t, 100> small;
+    etl::vector<uint8_t, jetlog::RawReader<>::MaxFrameSize> output;
+
+    logWriter.push("", jetlog::level::info, "Message");
+
+    // Record must stay in buffer
+    ASSERT_FALSE(rawReader.pull(small));
+    ASSERT_TRUE(rawReader.pull(output));
+}
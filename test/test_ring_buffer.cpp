@@ -1,6 +1,9 @@
 #include <gtest/gtest.h>
 #include "jetlog/private/ring_buffer.hpp"
 
+#include <functional>
+#include <vector>
+
 TEST(RingBufferTest, WriteAndReadSingleRecord) {
     jetlog::RingBuffer<1024> buffer{};
     etl::vector<uint8_t, 100> data(13, 0);
@@ -57,3 +60,521 @@ TEST(RingBufferTest, ReadFromEmptyBuffer) {
     ASSERT_FALSE(buffer.readRecord(readData));
     ASSERT_TRUE(readData.empty());
 }
+
+TEST(RingBufferTest, ReserveAndCommitWrapped) {
+    constexpr size_t bufferSize = 32;
+    jetlog::RingBuffer<bufferSize> buffer{};
+
+    etl::vector<uint8_t, 100> data1(20, 0);
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_TRUE(buffer.writeRecord(data1));
+    ASSERT_TRUE(buffer.readRecord(readData));
+
+    // Record data starts at 24 and wraps around buffer end
+    jetlog::RecordSpan span{};
+    ASSERT_TRUE(buffer.reserveRecord(12, span));
+    EXPECT_EQ(span.first_size, 8u);
+    EXPECT_EQ(span.second_size, 4u);
+
+    jetlog::RecordWriter writer{span};
+    for (uint8_t i = 0; i < 4; i++) { writer.push_back(i); }
+    const uint8_t tail[] = { 4, 5, 6, 7, 8, 9, 10, 11 };
+    writer.insert(writer.end(), tail, tail + sizeof(tail));
+    EXPECT_FALSE(writer.is_truncated());
+
+    // Nothing visible before commit
+    ASSERT_FALSE(buffer.readRecord(readData));
+    buffer.commitRecord(span);
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    etl::vector<uint8_t, 100> expected{ 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11 };
+    ASSERT_EQ(readData, expected);
+}
+
+TEST(RingBufferTest, ReserveTooBig) {
+    jetlog::RingBuffer<32> buffer{};
+    jetlog::RecordSpan span{};
+    etl::vector<uint8_t, 100> data(6, 1);
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_FALSE(buffer.reserveRecord(40, span));
+
+    // Failed reserve should not lock buffer
+    ASSERT_TRUE(buffer.writeRecord(data));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_EQ(readData, data);
+}
+
+TEST(RingBufferTest, OverflowDropNewest) {
+    jetlog::RingBuffer<32, jetlog::overflow::drop_newest> buffer{};
+    etl::vector<uint8_t, 100> data1(6, 0);
+    etl::vector<uint8_t, 100> data2(21, 1);
+    etl::vector<uint8_t, 100> data3(6, 2);
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_TRUE(buffer.writeRecord(data1));
+    ASSERT_TRUE(buffer.writeRecord(data2));
+    ASSERT_FALSE(buffer.writeRecord(data3));
+
+    EXPECT_EQ(buffer.getStats().records_evicted, 0u);
+    EXPECT_EQ(buffer.getStats().allocation_failures, 1u);
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_EQ(readData, data1);
+
+    // Space is available again after read
+    ASSERT_TRUE(buffer.writeRecord(data3));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_EQ(readData, data2);
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_EQ(readData, data3);
+}
+
+TEST(RingBufferTest, OverflowKeepErrors) {
+    jetlog::RingBuffer<31, jetlog::overflow::keep_errors> buffer{};
+    jetlog::RecordSpan span{};
+    etl::vector<uint8_t, 100> data(6, 0);
+    etl::vector<uint8_t, 100> readData{};
+
+    // [normal 8] [important 8] [normal 8]
+    ASSERT_TRUE(buffer.writeRecord(data));
+    ASSERT_TRUE(buffer.reserveRecord(6, span, true));
+    etl::fill_n(span.first, span.first_size, 7);
+    buffer.commitRecord(span);
+    ASSERT_TRUE(buffer.writeRecord(data));
+
+    // First record is evicted, then eviction stops at important one
+    ASSERT_TRUE(buffer.writeRecord(data));
+    ASSERT_FALSE(buffer.writeRecord(data));
+    EXPECT_EQ(buffer.getStats().records_evicted, 1u);
+
+    etl::vector<uint8_t, 100> important(6, 7);
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, important);
+
+    // After read, old records can be evicted as usual
+    ASSERT_TRUE(buffer.writeRecord(data));
+    ASSERT_TRUE(buffer.writeRecord(data));
+}
+
+TEST(RingBufferTest, Stats) {
+    jetlog::RingBuffer<32> buffer{};
+    jetlog::RecordSpan span{};
+    etl::vector<uint8_t, 100> data1(6, 0);
+    etl::vector<uint8_t, 100> data2(21, 1);
+    etl::vector<uint8_t, 100> data3(6, 2);
+
+    ASSERT_TRUE(buffer.writeRecord(data1));
+    ASSERT_TRUE(buffer.writeRecord(data2));
+    // Evicts data1
+    ASSERT_TRUE(buffer.writeRecord(data3));
+    ASSERT_FALSE(buffer.reserveRecord(40, span));
+
+    auto stats = buffer.getStats();
+    EXPECT_EQ(stats.records_written, 3u);
+    EXPECT_EQ(stats.bytes_written, 8u + 23u + 8u);
+    EXPECT_EQ(stats.records_evicted, 1u);
+    EXPECT_EQ(stats.allocation_failures, 1u);
+    EXPECT_EQ(stats.cas_retries, 0u);
+    EXPECT_EQ(stats.high_water_mark, 31u);
+
+    buffer.resetStats();
+    stats = buffer.getStats();
+    EXPECT_EQ(stats.records_written, 0u);
+    EXPECT_EQ(stats.high_water_mark, 0u);
+}
+
+namespace {
+
+class CountingWaiter : public jetlog::IWaiter {
+public:
+    void notify() override { count++; }
+    auto wait(uint32_t) -> bool override { return false; }
+
+    size_t count{0};
+};
+
+} // namespace
+
+TEST(RingBufferTest, NotifyOnData) {
+    jetlog::RingBuffer<1024> buffer{};
+    CountingWaiter waiter;
+    etl::vector<uint8_t, 100> data(10, 0);
+    etl::vector<uint8_t, 100> readData{};
+
+    buffer.setWaiter(&waiter);
+
+    // Notify only when data appears in empty buffer
+    buffer.writeRecord(data);
+    buffer.writeRecord(data);
+    EXPECT_EQ(waiter.count, 1u);
+
+    while (buffer.readRecord(readData)) {}
+
+    buffer.writeRecord(data);
+    EXPECT_EQ(waiter.count, 2u);
+}
+
+TEST(RingBufferTest, NotifyOnWatermark) {
+    jetlog::RingBuffer<1024> buffer{};
+    CountingWaiter waiter;
+    etl::vector<uint8_t, 100> data(10, 0);
+
+    // 12 bytes per record, notify on the 3rd one
+    buffer.setWaiter(&waiter, 30);
+
+    buffer.writeRecord(data);
+    buffer.writeRecord(data);
+    EXPECT_EQ(waiter.count, 0u);
+    buffer.writeRecord(data);
+    EXPECT_EQ(waiter.count, 1u);
+    buffer.writeRecord(data);
+    EXPECT_EQ(waiter.count, 1u);
+}
+
+namespace {
+
+class CollectingConsumer : public jetlog::IRecordConsumer {
+public:
+    auto consume(const etl::ivector<uint8_t>& data) -> bool override {
+        records.emplace_back(data.begin(), data.end());
+        if (onConsume) { onConsume(); }
+        return records.size() < stopAfter;
+    }
+
+    void onGap() override { gaps++; }
+
+    std::vector<std::vector<uint8_t>> records;
+    std::function<void()> onConsume;
+    size_t stopAfter{SIZE_MAX};
+    size_t gaps{0};
+};
+
+} // namespace
+
+TEST(RingBufferTest, ReadRecordsBatch) {
+    jetlog::RingBuffer<1024> buffer{};
+    etl::vector<uint8_t, 100> readData{};
+
+    for (uint8_t i = 0; i < 5; i++) {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(i + 1, i)));
+    }
+
+    CollectingConsumer consumer{};
+    EXPECT_EQ(buffer.readRecords(readData, consumer, 2), 2u);
+    consumer.stopAfter = 3;
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 1u);
+    consumer.stopAfter = SIZE_MAX;
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 2u);
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 0u);
+
+    ASSERT_EQ(consumer.records.size(), 5u);
+    for (uint8_t i = 0; i < 5; i++) {
+        EXPECT_EQ(consumer.records[i], std::vector<uint8_t>(i + 1, i));
+    }
+}
+
+TEST(RingBufferTest, ReadRecordsBatchEvictedBehind) {
+    jetlog::RingBuffer<31> buffer{};
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 0)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 1)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 2)));
+
+    // While second record is processed, writer evicts the first one only.
+    CollectingConsumer consumer{};
+    consumer.onConsume = [&]() {
+        if (consumer.records.size() == 2) {
+            ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 3)));
+        }
+    };
+
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 2u);
+
+    // Consumed records must not be returned again
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(6, 2)));
+}
+
+TEST(RingBufferTest, ReadRecordsBatchEvictedAhead) {
+    jetlog::RingBuffer<31> buffer{};
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 0)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 1)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 2)));
+
+    // While first record is processed, writer evicts two records. Batch must
+    // stop, because second record can be overwritten.
+    CollectingConsumer consumer{};
+    consumer.onConsume = [&]() {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(14, 3)));
+    };
+
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 1u);
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(6, 2)));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(14, 3)));
+}
+
+// Runs hook once on data read, to emulate writer, which works in parallel
+// with reader
+template <size_t BufferSize>
+class HookedStorage : public jetlog::ArrayStorage<BufferSize> {
+public:
+    auto data() -> uint8_t* { return jetlog::ArrayStorage<BufferSize>::data(); }
+
+    auto data() const -> const uint8_t* {
+        if (hook) {
+            auto run = hook;
+            hook = nullptr;
+            run();
+        }
+        return jetlog::ArrayStorage<BufferSize>::data();
+    }
+
+    mutable std::function<void()> hook;
+};
+
+class HookedRingBuffer : public jetlog::BasicRingBuffer<HookedStorage<32>> {
+public:
+    auto hookedStorage() -> HookedStorage<32>& { return storage; }
+};
+
+TEST(RingBufferTest, ReadRecordsBatchEvictedBeforeFirst) {
+    HookedRingBuffer buffer{};
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 9)));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 0)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 1)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 2)));
+
+    // Writer evicts the first record before reader copies it. Batch must
+    // restart from the new tail, not return empty.
+    buffer.hookedStorage().hook = [&]() {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(14, 3)));
+    };
+
+    CollectingConsumer consumer{};
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 3u);
+    EXPECT_EQ(consumer.gaps, 1u);
+    ASSERT_EQ(consumer.records.size(), 3u);
+    EXPECT_EQ(consumer.records[0], std::vector<uint8_t>(6, 1));
+    EXPECT_EQ(consumer.records[2], std::vector<uint8_t>(14, 3));
+}
+
+TEST(RingBufferTest, PowerOfTwoFullCapacity) {
+    etl::vector<uint8_t, 100> readData{};
+
+    // Power of two size - whole buffer can be used
+    jetlog::RingBuffer<32> buffer{};
+    for (uint8_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, i)));
+    }
+    EXPECT_EQ(buffer.getStats().records_evicted, 0u);
+    EXPECT_EQ(buffer.getStats().high_water_mark, 32u);
+
+    // Indices keep growing, positions are wrapped by mask
+    for (uint8_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(buffer.readRecord(readData));
+    }
+    for (uint8_t i = 4; i < 100; i++) {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(5, i)));
+        ASSERT_TRUE(buffer.readRecord(readData));
+    }
+    EXPECT_EQ(buffer.getStats().records_evicted, 0u);
+
+    // Other sizes reserve 1 byte
+    jetlog::RingBuffer<33> other{};
+    for (uint8_t i = 0; i < 4; i++) {
+        ASSERT_TRUE(other.writeRecord(etl::vector<uint8_t, 100>(6, i)));
+    }
+    ASSERT_TRUE(other.writeRecord(etl::vector<uint8_t, 100>(0, 0)));
+    EXPECT_EQ(other.getStats().records_evicted, 1u);
+}
+
+TEST(RingBufferTest, ContiguousRecords) {
+    jetlog::RingBuffer<32, jetlog::overflow::evict_oldest, true> buffer{};
+    jetlog::RecordSpan span{};
+    etl::vector<uint8_t, 100> readData{};
+
+    // [9] [9] [9] [5 free] - next record does not fit before end, so it
+    // goes to the start, and the end is padded
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(7, 0)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(7, 1)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(7, 2)));
+
+    ASSERT_TRUE(buffer.reserveRecord(7, span));
+    EXPECT_EQ(span.first_size, 7u);
+    EXPECT_EQ(span.second_size, 0u);
+    etl::fill_n(span.first, span.first_size, 3);
+    buffer.commitRecord(span);
+
+    // Padding is not a record
+    EXPECT_EQ(buffer.getStats().records_evicted, 1u);
+
+    for (uint8_t i = 1; i < 4; i++) {
+        ASSERT_TRUE(buffer.readRecord(readData));
+        EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(7, i)));
+    }
+    EXPECT_FALSE(buffer.readRecord(readData));
+
+    // Tail of 1 byte (less than header) is skipped without padding header
+    buffer.reset();
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(29, 4)));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(4, 5)));
+
+    CollectingConsumer consumer{};
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 1u);
+    ASSERT_EQ(consumer.records.size(), 1u);
+    EXPECT_EQ(consumer.records[0], std::vector<uint8_t>(4, 5));
+
+    // Random sizes (up to half of buffer), each record is in one piece
+    buffer.reset();
+    for (uint8_t i = 0; i < 200; i++) {
+        size_t size = (i * 7) % 15;
+        ASSERT_TRUE(buffer.reserveRecord(size, span));
+        EXPECT_EQ(span.second_size, 0u);
+        etl::fill_n(span.first, span.first_size, i);
+        buffer.commitRecord(span);
+
+        if (i % 3 == 0) {
+            ASSERT_TRUE(buffer.readRecord(readData));
+        }
+    }
+    // The last record is always available
+    size_t last_size{0};
+    while (buffer.readRecord(readData)) { last_size = readData.size(); }
+    EXPECT_EQ(last_size, (199u * 7) % 15);
+}
+
+TEST(RingBufferTest, CacheAlignedLayout) {
+    using Storage = jetlog::ArrayStorage<32, 64>;
+    Storage storage{};
+
+    auto addr = [](const void* p) { return reinterpret_cast<uintptr_t>(p); };
+    const auto& ctrl = storage.control();
+
+    // Writers and reader sides must not share cache lines, and data too
+    EXPECT_EQ(addr(&ctrl) % 64, 0u);
+    EXPECT_GE(addr(&ctrl.head_idx) - addr(&ctrl.upcoming_idx), 64u);
+    EXPECT_GE(addr(&ctrl.tail_idx) - addr(&ctrl.head_idx), 64u);
+    EXPECT_GE(addr(storage.data()) - addr(&ctrl.tail_idx), 64u);
+
+    // Works the same as default one
+    jetlog::CacheAlignedRingBuffer<32> buffer{};
+    etl::vector<uint8_t, 100> readData{};
+
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 0)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(21, 1)));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(6, 2)));
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(21, 1)));
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(6, 2)));
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
+
+TEST(RingBufferTest, ViewRecord) {
+    jetlog::RingBuffer<32> buffer{};
+    jetlog::RecordView view{};
+    etl::vector<uint8_t, 100> readData{};
+
+    EXPECT_FALSE(buffer.viewRecord(view));
+
+    // In one piece, stays in buffer until consumed
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(20, 1)));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_EQ(view.first_size, 20u);
+    EXPECT_EQ(view.second_size, 0u);
+    EXPECT_EQ(view.first[0], 1);
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_TRUE(buffer.consumeRecord(view));
+    EXPECT_FALSE(buffer.viewRecord(view));
+
+    // Wrapped at buffer end: [22 used] [2 header] [8 data] ... [7 data]
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(15, 2)));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_EQ(view.first_size, 8u);
+    EXPECT_EQ(view.second_size, 7u);
+    EXPECT_EQ(view.size(), 15u);
+    EXPECT_EQ(view.first[7], 2);
+    EXPECT_EQ(view.second[6], 2);
+    EXPECT_TRUE(buffer.consumeRecord(view));
+
+    // Evicted by writer while viewed - consume fails, next record is intact
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(10, 3)));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(25, 4)));
+    EXPECT_FALSE(buffer.consumeRecord(view));
+
+    ASSERT_TRUE(buffer.readRecord(readData));
+    EXPECT_EQ(readData, (etl::vector<uint8_t, 100>(25, 4)));
+    EXPECT_FALSE(buffer.readRecord(readData));
+}
+
+TEST(RingBufferTest, GapAfterEviction) {
+    jetlog::RingBuffer<64> buffer{};
+    jetlog::RecordView view{};
+    etl::vector<uint8_t, 100> readData{};
+    CollectingConsumer consumer{};
+
+    // Nothing read yet, no gap
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(10, 1)));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_FALSE(view.follows_gap);
+    ASSERT_TRUE(buffer.consumeRecord(view));
+
+    // Read in order
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(10, 2)));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_FALSE(view.follows_gap);
+    ASSERT_TRUE(buffer.consumeRecord(view));
+
+    // Writers evicted unread records (5 fit in buffer)
+    for (uint8_t i = 3; i < 10; i++) {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(10, i)));
+    }
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_EQ(view.first[0], 5);
+    EXPECT_TRUE(view.follows_gap);
+    ASSERT_TRUE(buffer.consumeRecord(view));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_FALSE(view.follows_gap);
+    while (buffer.readRecord(readData)) {}
+
+    // The same for batch read, reported once, before the first record
+    for (uint8_t i = 10; i < 17; i++) {
+        ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(10, i)));
+    }
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 5u);
+    EXPECT_EQ(consumer.gaps, 1u);
+
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(10, 17)));
+    EXPECT_EQ(buffer.readRecords(readData, consumer), 1u);
+    EXPECT_EQ(consumer.gaps, 1u);
+}
+
+TEST(RingBufferTest, NoGapAfterPadding) {
+    jetlog::RingBuffer<64, jetlog::overflow::evict_oldest, true> buffer{};
+    jetlog::RecordView view{};
+
+    // The second record does not fit before buffer end, padding is skipped
+    // by reader
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(40, 1)));
+    ASSERT_TRUE(buffer.viewRecord(view));
+    ASSERT_TRUE(buffer.consumeRecord(view));
+    ASSERT_TRUE(buffer.writeRecord(etl::vector<uint8_t, 100>(30, 2)));
+
+    ASSERT_TRUE(buffer.viewRecord(view));
+    EXPECT_EQ(view.first[0], 2);
+    EXPECT_FALSE(view.follows_gap);
+}
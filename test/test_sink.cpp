@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+#include "jetlog/fd_sink.hpp"
+
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+
+struct ChunksSink : public jetlog::ISink {
+    void write(const char* data, size_t size) override { chunks.emplace_back(data, size); }
+    void flush() override { flushes++; }
+
+    std::vector<std::string> chunks;
+    int flushes{0};
+};
+
+} // namespace
+
+TEST(SinkTest, BufferedSinkChunks) {
+    ChunksSink next;
+    jetlog::BufferedSink<4> sink{next};
+
+    sink.write("ab", 2);
+    EXPECT_TRUE(next.chunks.empty());
+
+    // Crosses chunk border twice
+    sink.write("cdefghij", 8);
+    EXPECT_EQ(next.chunks, (std::vector<std::string>{ "abcd", "efgh" }));
+
+    sink.flush();
+    EXPECT_EQ(next.chunks, (std::vector<std::string>{ "abcd", "efgh", "ij" }));
+    EXPECT_EQ(next.flushes, 1);
+
+    // Nothing to pass out, but flush is forwarded
+    sink.flush();
+    EXPECT_EQ(next.chunks.size(), 3u);
+    EXPECT_EQ(next.flushes, 2);
+}
+
+TEST(SinkTest, FdSinkPipe) {
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    jetlog::FdSink sink{fds[1]};
+    sink.write("Hello, ", 7);
+    sink.write("pipe", 4);
+    EXPECT_FALSE(sink.hasFailed());
+    close(fds[1]);
+
+    char data[32];
+    auto size = read(fds[0], data, sizeof(data));
+    close(fds[0]);
+
+    ASSERT_EQ(size, 11);
+    EXPECT_EQ(std::string(data, 11), "Hello, pipe");
+
+    // Closed descriptor
+    jetlog::FdSink broken{fds[1]};
+    broken.write("x", 1);
+    EXPECT_TRUE(broken.hasFailed());
+}
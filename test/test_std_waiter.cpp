@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+#include "jetlog/jetlog.hpp"
+#include "jetlog/std_waiter.hpp"
+
+#include <thread>
+
+TEST(StdWaiterTest, NotifyBeforeWait) {
+    jetlog::StdWaiter waiter;
+
+    EXPECT_FALSE(waiter.wait(1));
+
+    // Notification is remembered until wait()
+    waiter.notify();
+    EXPECT_TRUE(waiter.wait(0));
+    EXPECT_FALSE(waiter.wait(1));
+}
+
+TEST(StdWaiterTest, ReaderWakeup) {
+    constexpr uint32_t Records = 1000;
+
+    jetlog::RingBuffer<1024 * 64> ringBuffer;
+    jetlog::StdWaiter waiter;
+    jetlog::Writer<> logWriter(ringBuffer);
+    jetlog::Reader<> logReader(ringBuffer);
+    etl::string<100> output;
+
+    ringBuffer.setWaiter(&waiter);
+
+    std::thread writer([&]() {
+        for (uint32_t i = 0; i < Records; i++) {
+            logWriter.push("", jetlog::level::info, "Record {}", i);
+            if (i % 100 == 0) { std::this_thread::yield(); }
+        }
+    });
+
+    uint32_t received = 0;
+
+    // Read until empty, then sleep. Timeout is only a guard against test
+    // hang, wakeups should never be lost.
+    while (received < Records) {
+        while (logReader.pull(output)) {
+            output.clear();
+            received++;
+        }
+        if (received < Records) { ASSERT_TRUE(waiter.wait(5000)); }
+    }
+
+    writer.join();
+    EXPECT_EQ(received, Records);
+}
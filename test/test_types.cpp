@@ -289,6 +289,109 @@ TEST(TypesTest, CharPtrEncodeDecode) {
     EXPECT_EQ(result, test_str);
 }
 
+// Writer passes C strings with precalculated length
+TEST(TypesTest, SizedCStringEncode) {
+    etl::vector<uint8_t, 100> plain{};
+    etl::vector<uint8_t, 100> sized{};
+    const char* test_str = "Hello, World!";
+
+    Encoders::write(test_str, plain);
+    Encoders::write(SizedCString{test_str, strlen(test_str)}, sized);
+
+    EXPECT_EQ(sized, plain);
+    EXPECT_EQ(Encoders::size(SizedCString{test_str, strlen(test_str)}), plain.size());
+
+    // Length is not recalculated
+    sized.clear();
+    Encoders::write(SizedCString{test_str, 5}, sized);
+    etl::string<100> result;
+    DecoderStr(sized, 0).format(result);
+    EXPECT_EQ(result, "Hello");
+}
+
+TEST(TypesTest, StaticStrEncodeDecode) {
+    etl::vector<uint8_t, 100> buffer{};
+    static const char* names[] = { "Idle", "Running" };
+
+    // Only pointer is stored
+    Encoders::write(static_str(names[1]), buffer);
+    EXPECT_EQ(IDecoder::readHeader(buffer, 0).typeId, static_cast<uint8_t>(DataType::StrRef));
+    EXPECT_EQ(buffer.size(), DataHeaderSize + sizeof(uintptr_t));
+    EXPECT_EQ(Encoders::size(static_str(names[1])), buffer.size());
+
+    etl::string<100> result;
+    DecoderStrRef decoder(buffer, 0);
+    decoder.format(result);
+
+    EXPECT_EQ(result, "Running");
+
+    // Null pointer gives empty string
+    buffer.clear();
+    result.clear();
+    Encoders::write(static_str(nullptr), buffer);
+    DecoderStrRef(buffer, 0).format(result);
+    EXPECT_EQ(result, "");
+}
+
+TEST(TypesTest, StaticStrNotResolved) {
+    etl::vector<uint8_t, 100> buffer{};
+    static const char* names[] = { "Idle", "Running" };
+
+    // Not validated data, pointer is not followed
+    Encoders::write(static_str(names[1]), buffer);
+    RecordData record{buffer, false};
+
+    etl::string<100> result;
+    DecoderStrRef(record, 0).format(result);
+    EXPECT_EQ(result, "<ref>");
+    EXPECT_EQ(IDecoder::getAsStringView(record, 0), "<ref>");
+    EXPECT_EQ(IDecoder::getAsStringView(buffer, 0), "Running");
+}
+
+TEST(TypesTest, WireFormat) {
+    etl::vector<uint8_t, 100> buffer{};
+
+    // Header (size, type) and value are little-endian on any target
+    Encoders::write(uint32_t{0x12345678}, buffer);
+    Encoders::write(int16_t{-2}, buffer);
+    Encoders::write(1.0f, buffer);
+
+    const uint8_t expected[] = {
+        4, 0, static_cast<uint8_t>(DataType::U32), 0x78, 0x56, 0x34, 0x12,
+        2, 0, static_cast<uint8_t>(DataType::I16), 0xFE, 0xFF,
+        4, 0, static_cast<uint8_t>(DataType::Flt), 0x00, 0x00, 0x80, 0x3F
+    };
+    ASSERT_EQ(buffer.size(), sizeof(expected));
+    EXPECT_TRUE(etl::equal(buffer.begin(), buffer.end(), expected));
+
+    // Short data is zero-extended
+    EXPECT_EQ(IDecoder::getAsNum<uint64_t>(buffer, 0), 0x12345678u);
+    EXPECT_EQ(IDecoder::getAsNum<int16_t>(buffer, 7), -2);
+    EXPECT_EQ(loadLE<uint32_t>(expected + 10, 2), 0xFFFEu);
+}
+
+TEST(TypesTest, EncodedSize) {
+    etl::vector<uint8_t, 100> buffer{};
+    const int16_t i16_val = -5;
+    const uint64_t u64_val = 5;
+    const double dbl_val = 1.5;
+    const char* str_val = "test";
+    std::string std_str = "std_str";
+
+    // Numeric sizes are known at compile time
+    static_assert(Encoders::fixed_size<int16_t>::value == 5, "");
+    static_assert(Encoders::fixed_size<double>::value == 11, "");
+
+    Encoders::write(i16_val, buffer);
+    Encoders::write(u64_val, buffer);
+    Encoders::write(dbl_val, buffer);
+    Encoders::write(str_val, buffer);
+    Encoders::write(std_str, buffer);
+
+    EXPECT_EQ(Encoders::size(i16_val, u64_val, dbl_val, str_val, std_str), buffer.size());
+    EXPECT_EQ(Encoders::size(str_val), 7u);
+}
+
 /* This is not actual, because we force literal types decay in push.
 TEST(TypesTest, StringLiteralTest) {
     etl::vector<uint8_t, 100> buffer{};
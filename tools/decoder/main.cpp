@@ -0,0 +1,119 @@
+//
+// Host side decoder for binary log stream, produced by jetlog::RawReader.
+//
+// Usage:
+//
+//   jetlog_decoder [--compact] [--json] [file]
+//
+// Reads frames from file (or stdin, if not set) and prints text lines to
+// stdout. Use `--compact` if device writes with CompactParamEncoders_*. Can be used with serial port device directly, for example:
+//
+//   jetlog_decoder /dev/ttyUSB0
+//
+// With `--json`, prints JSON lines instead of text (see JsonFormatter), for
+// log collectors.
+//
+
+#include "jetlog/jetlog.hpp"
+#include "jetlog/fd_sink.hpp"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace {
+
+// Decode all known types, independent on writer configuration. Type IDs are
+// the same for all lists.
+using Formatter = jetlog::RecordFormatter<
+    jetlog::ParamDecoders_64_And_Double,
+    jetlog::FormatCache<256>
+>;
+
+using CompactFormatter = jetlog::RecordFormatter<
+    jetlog::CompactParamDecoders_64_And_Double,
+    jetlog::FormatCache<256>
+>;
+
+using JsonFormatter = jetlog::JsonFormatter<jetlog::ParamDecoders_64_And_Double>;
+
+using CompactJsonFormatter = jetlog::JsonFormatter<jetlog::CompactParamDecoders_64_And_Double>;
+
+template <typename F>
+void decode(FILE* input) {
+    // Static, to avoid big objects on stack
+    static jetlog::RawFrameDecoder<1024> decoder;
+    static F formatter;
+    // Lines are streamed, no limit for length
+    static jetlog::FdSink stdoutSink{fileno(stdout)};
+    static jetlog::BufferedSink<4096> output{stdoutSink};
+
+    uint8_t chunk[256];
+    size_t size;
+
+    while ((size = fread(chunk, 1, sizeof(chunk), input)) > 0) {
+        for (size_t i = 0; i < size; i++) {
+            if (!decoder.feed(chunk[i])) { continue; }
+
+            // Stream can have noise, which passes CRC. Pointers (if any)
+            // are not valid on host anyway, never follow those.
+            jetlog::RecordData record{decoder.record(), false};
+
+            // Gaps in sequence numbers (if writer adds those)
+            if (formatter.formatLost(record, output)) {
+                output.write("\n", 1);
+            }
+
+            // Broken record may be written partially, end the line anyway
+            formatter.formatRecord(record, output);
+            output.write("\n", 1);
+        }
+        output.flush();
+    }
+
+    // Gap before the last record, if late records did not fill it
+    if (formatter.formatPendingLost(output)) {
+        output.write("\n", 1);
+        output.flush();
+    }
+
+    if (decoder.errors() > 0) {
+        fprintf(stderr, "Broken frames: %zu\n", decoder.errors());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    FILE* input = stdin;
+    bool compact = false;
+    bool json = false;
+    int arg = 1;
+
+    for (; arg < argc && strncmp(argv[arg], "--", 2) == 0; arg++) {
+        if (strcmp(argv[arg], "--compact") == 0) {
+            compact = true;
+        } else if (strcmp(argv[arg], "--json") == 0) {
+            json = true;
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[arg]);
+            return 1;
+        }
+    }
+
+    if (arg < argc) {
+        input = fopen(argv[arg], "rb");
+        if (!input) {
+            fprintf(stderr, "Can not open %s\n", argv[arg]);
+            return 1;
+        }
+    }
+
+    if (json) {
+        if (compact) { decode<CompactJsonFormatter>(input); } else { decode<JsonFormatter>(input); }
+    } else {
+        if (compact) { decode<CompactFormatter>(input); } else { decode<Formatter>(input); }
+    }
+
+    if (input != stdin) { fclose(input); }
+    return 0;
+}